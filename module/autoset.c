@@ -0,0 +1,208 @@
+/*
+ * autoset.c
+ *
+ * Automatic timebase, vertical scale and trigger level
+ *
+ * The main loop copies a window of recent samples and works through it a
+ * chunk per poll: first the range, then rising crossings of the midpoint
+ * for the period. If the window held too few periods, or too few samples
+ * per period, it retunes to the slowest or fastest zoom and looks again.
+ * Acquisition carries on throughout. Period and trigger level come from
+ * channel A, which the trigger watches, while the vertical scale is fitted
+ * to the displayed trace.
+ *                                                                          */
+
+#include "autoset.h"
+#include "mask.h"
+#include "scope.h"
+#include "telescope.h"
+#include "timebase.h"
+#include "trigger.h"
+
+typedef enum {
+    AUTOSET_IDLE,
+    AUTOSET_SETTLE, // waiting for the zoom to take effect
+    AUTOSET_FILL,   // waiting for a window of samples at the new zoom
+    AUTOSET_RANGE,
+    AUTOSET_PERIOD
+} autoset_state;
+
+static uint16_t window[AUTOSET_LENGTH];       // channel A, which triggers
+static uint16_t trace_window[AUTOSET_LENGTH]; // the displayed trace
+static autoset_state state = AUTOSET_IDLE;
+static scope_display_mode resume_mode;
+static int16_t probe_zoom;
+static uint32_t fill_start;
+static uint32_t rate;
+static uint16_t pos;
+
+static uint16_t lo, hi;
+static uint16_t trace_lo, trace_hi;
+static bool armed;
+static uint16_t crossings;
+static uint16_t first, last;
+
+// Refused while the mask holds the display, since the zoom can't change
+void autoset_start(void) {
+    if (mask_frozen())
+        return;
+
+    if (state == AUTOSET_IDLE)
+        resume_mode = scope_get_mode();
+    // segments mode doesn't keep the sample ring, so leave it until done
+    if (resume_mode == SCOPE_MODE_SEGMENTS)
+        scope_mode(SCOPE_MODE_YT);
+
+    probe_zoom = 1;
+    scope_zoom(probe_zoom);
+    state = AUTOSET_SETTLE;
+}
+
+bool autoset_busy(void) {
+    return state != AUTOSET_IDLE;
+}
+
+// Smallest power of two zoom whose screen holds at least two periods
+static int16_t period_zoom(uint32_t period) {
+    // compare at the measured rate rather than scaling the period down
+    uint64_t want = 2ULL * period * SAMPLE_RATE;
+
+    for (int16_t z = SCOPE_MAX_ZOOM; z > 1; z /= 2) {
+        if ((uint64_t)scope_zoom_span(z) * rate >= want)
+            return z;
+    }
+    for (int16_t z = 1; z < SCOPE_MIN_ZOOM; z *= 2) {
+        int16_t slow = z == 1 ? 1 : -z;
+        if ((uint64_t)scope_zoom_span(slow) * rate >= want)
+            return slow;
+    }
+    return -SCOPE_MIN_ZOOM;
+}
+
+// Largest power of two gain that keeps the signal on screen with margin
+static uint8_t range_gain(uint16_t pp) {
+    uint8_t g = 1;
+    while (g < AUTOSET_MAX_GAIN &&
+            (uint32_t)pp * g * 2 <= (SCOPE_SAMPLE_MAX + 1) * 3 / 4)
+        g *= 2;
+    return g;
+}
+
+static void stop(void) {
+    if (resume_mode == SCOPE_MODE_SEGMENTS)
+        scope_mode(SCOPE_MODE_SEGMENTS);
+    state = AUTOSET_IDLE;
+}
+
+static void finish(void) {
+    uint16_t mid = lo + (hi - lo) / 2;
+    bool flat = hi - lo < AUTOSET_FLAT;
+    uint16_t trace_pp = trace_hi - trace_lo;
+
+    trigger_set_level(mid);
+    scope_vertical(trace_pp < AUTOSET_FLAT ? 1 : range_gain(trace_pp),
+                   trace_lo + trace_pp / 2);
+
+    if (flat)
+        scope_zoom(1);
+    else if (crossings >= 3)
+        scope_zoom(period_zoom((last - first) / (crossings - 1)));
+    else // slower than the window, show as much as possible
+        scope_zoom(-SCOPE_MIN_ZOOM);
+
+    stop();
+}
+
+// Look again at another zoom, or settle for what this pass found
+static void analysed(void) {
+    bool flat = hi - lo < AUTOSET_FLAT;
+    uint32_t period = crossings >= 2 ? (last - first) / (crossings - 1) : 0;
+
+    if (!flat && probe_zoom == 1) {
+        if (crossings < 3) {
+            probe_zoom = -SCOPE_MIN_ZOOM;
+            scope_zoom(probe_zoom);
+            state = AUTOSET_SETTLE;
+            return;
+        }
+        if (period < AUTOSET_MIN_PERIOD) {
+            probe_zoom = SCOPE_MAX_ZOOM;
+            scope_zoom(probe_zoom);
+            state = AUTOSET_SETTLE;
+            return;
+        }
+    }
+
+    finish();
+}
+
+void autoset_poll(void) {
+    // a failing mask holds the display and with it any zoom change
+    if (state != AUTOSET_IDLE && mask_frozen()) {
+        stop();
+        return;
+    }
+
+    switch (state) {
+        case AUTOSET_SETTLE:
+            if (scope_get_zoom() != probe_zoom ||
+                    scope_get_mode() == SCOPE_MODE_SEGMENTS)
+                return;
+            fill_start = scope_ticks();
+            state = AUTOSET_FILL;
+            return;
+
+        case AUTOSET_FILL:
+            if (scope_ticks() - fill_start < AUTOSET_LENGTH)
+                return;
+            rate = timebase_rate();
+            scope_history(window, trace_window, AUTOSET_LENGTH);
+            lo = trace_lo = SCOPE_SAMPLE_MAX;
+            hi = trace_hi = 0;
+            pos = 0;
+            state = AUTOSET_RANGE;
+            return;
+
+        case AUTOSET_RANGE:
+            for (uint16_t n = 0; n < AUTOSET_CHUNK && pos < AUTOSET_LENGTH; n++, pos++) {
+                if (window[pos] < lo)
+                    lo = window[pos];
+                if (window[pos] > hi)
+                    hi = window[pos];
+                if (trace_window[pos] < trace_lo)
+                    trace_lo = trace_window[pos];
+                if (trace_window[pos] > trace_hi)
+                    trace_hi = trace_window[pos];
+            }
+            if (pos < AUTOSET_LENGTH)
+                return;
+            armed = false;
+            crossings = 0;
+            pos = 0;
+            state = AUTOSET_PERIOD;
+            return;
+
+        case AUTOSET_PERIOD: {
+            uint16_t mid = lo + (hi - lo) / 2;
+            uint16_t hyst = (hi - lo) / 8;
+            for (uint16_t n = 0; n < AUTOSET_CHUNK && pos < AUTOSET_LENGTH; n++, pos++) {
+                if (window[pos] + hyst < mid)
+                    armed = true;
+                else if (armed && window[pos] >= mid) {
+                    armed = false;
+                    if (crossings == 0)
+                        first = pos;
+                    last = pos;
+                    crossings++;
+                }
+            }
+            if (pos < AUTOSET_LENGTH)
+                return;
+            analysed();
+            return;
+        }
+
+        default:
+            return;
+    }
+}
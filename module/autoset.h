@@ -0,0 +1,17 @@
+#ifndef AUTOSET_H
+#define AUTOSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUTOSET_LENGTH 1024   // samples analysed per pass
+#define AUTOSET_CHUNK 128     // samples analysed per poll
+#define AUTOSET_MIN_PERIOD 8  // samples, below this sample faster
+#define AUTOSET_MAX_GAIN 8
+#define AUTOSET_FLAT 128      // peak to peak below this is treated as DC
+
+void autoset_start(void);
+bool autoset_busy(void);
+void autoset_poll(void);
+
+#endif
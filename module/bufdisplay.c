@@ -8,6 +8,7 @@
  *   - TODO 4-bit display for fidelity
  *   - 2x1 pixel updates for low-density graphics, such as an oscilloscope
  *   - TODO 2x64 pixel updates for complex operations
+ *   - Infinite or decaying persistence
  *
  *                                                                          */
 
@@ -15,29 +16,88 @@
 #include "display.h"
 
 #include <stdbool.h>
-#include <string.h> // memcmp()
+#include <string.h> // memcmp(), memset()
 
 /*
- * Internal data type: column
- * Each bit represents a set pixel
+ * Shadowed buffer system
  *
- * uint64_t won't work on AVR32
+ * Screen updates occur on the shadow, live screen holds current screen state
  *                                                                           */
-typedef uint32_t column[2];
-/*                               LSb    MSb
- *                     [0] = row   0 to 31 
- *                     [1] = row  32 to 63
+static column  shadow[128];
+static column  live[128];
+
+/*
+ * Persistence buffer
+ *
+ * Each pixel carries a bit-sliced age counter stored alongside its column,
+ * one column per counter bit, so a whole column ages in a few word ops.
+ * A pixel stays lit while its age is non-zero.
  *                                                                           */
+static column  persist[128][DISPLAY_PERSIST_BITS];
+static uint8_t persist_frames = DISPLAY_PERSIST_OFF;
+
+#if DISPLAY_PERSIST_BITS != 4
+#error "age_column() and set_age() are unrolled for 4 bit counters"
+#endif
 
 /*
- * Reverse-shadowed buffer system
+ * Dirty column pairs
  *
- * Screen updates occur on the shadow, live screen holds current screen state
+ * One bit per column pair whose shadow may differ from the live screen,
+ * so random-access drawing only renders the pairs it touched
  *                                                                           */
-static column  buf_1[128];
-static column  buf_2[128];
-static column* shadow = buf_1;
-static column* live = buf_2;
+static uint32_t dirty[2];
+static uint8_t  dirty_cursor = 0;
+
+static inline void mark_dirty(uint8_t col) {
+    dirty[col > 63] |= 1 << ((col / 2) & 31);
+}
+
+/*
+ * Stale column pairs
+ *
+ * One bit per pair not yet carried into the current frame. Each pair is
+ * cleared or aged the first time it is touched, so starting a frame only
+ * costs a few word writes inside the sample interrupt.
+ *                                                                           */
+static uint32_t stale[2];
+
+static void freshen(uint8_t col);
+
+/*
+ * Rolling accumulation
+ *
+ * For random-access drawing such as XY, which draws into pairs after the
+ * sweep has passed them. Rather than every pair starting afresh at the
+ * frame boundary, each one starts its next accumulation as soon as it is
+ * rendered, so it shows everything drawn since its previous render.
+ *                                                                           */
+static bool rolling = false;
+
+/*
+ * Overlay
+ *
+ * Text, mask bands and reference traces are drawn over the shadow rather
+ * than into it, so persistence never applies to them. Each pair's overlay
+ * is cleared the first time it is drawn to or rendered in a new frame,
+ * and pairs that held any overlay are rendered again so it can be erased.
+ *                                                                           */
+static column   overlay[128];
+static uint32_t overlay_used[2];
+static uint32_t overlay_stale[2];
+
+static inline void overlay_freshen(uint8_t col) {
+    uint8_t i = col & ~1;
+    uint32_t bit = 1 << ((i / 2) & 31);
+    if (!(overlay_stale[i > 63] & bit))
+        return;
+    overlay_stale[i > 63] &= ~bit;
+    overlay_used[i > 63] &= ~bit;
+    overlay[i][0] = 0;
+    overlay[i][1] = 0;
+    overlay[i + 1][0] = 0;
+    overlay[i + 1][1] = 0;
+}
 
 /*
  * Internal data type: column_operations
@@ -52,35 +112,66 @@ typedef struct {
 } column_operations;
 
 
-static inline void render_columns(column_operations* op) {
-    uint32_t p;
-    uint8_t ri;
-    for (uint8_t i = 0; i < 64; i++) {
-        if (i > 31) {
-            ri = 1;
-            p = (1 << (i-32));
-        }
-        else {
-            ri = 0;
-            p = (1 << i);
-        }
-        
-        if (p & op->erase_1[ri] || p & op->write_1[ri] ||
-                p & op->erase_2[ri] || p & op->write_2[ri]) {
+/*
+ * Command stream
+ *
+ * A column pair update is encoded here first and then sent in one burst,
+ * rather than one polled spi_write() per byte. Runs of bytes sharing a
+ * DC level are prefixed with a D_BURST_* header byte.
+ *                                                                           */
+static uint8_t  stream[256];
+static uint16_t stream_len;
+static uint16_t stream_hdr;
+
+static inline void stream_byte(uint8_t dc, uint8_t b) {
+    uint8_t hdr = stream[stream_hdr];
+    if (stream_len == 0 || (hdr & D_BURST_DATA) != dc ||
+            (hdr & D_BURST_LENGTH) == D_BURST_LENGTH) {
+        stream_hdr = stream_len;
+        stream[stream_len++] = dc;
+    }
+    stream[stream_hdr]++;
+    stream[stream_len++] = b;
+}
 
+static inline bool row_changed(column_operations* op, uint8_t ri, uint32_t p) {
+    return p & (op->erase_1[ri] | op->write_1[ri] |
+                op->erase_2[ri] | op->write_2[ri]);
+}
+
+static inline void render_columns(uint8_t i, column_operations* op) {
+    stream_len = 0;
+    stream_byte(D_BURST_COMMAND, D_SET_COL);
+    stream_byte(D_BURST_COMMAND, i / 2);
+    stream_byte(D_BURST_COMMAND, i / 2);
+
+    // consecutive changed rows share one row window
+    int8_t start = -1;
+    for (uint8_t r = 0; r <= 64; r++) {
+        bool changed = r < 64 && row_changed(op, r > 31, 1 << (r & 31));
+        if (changed && start < 0)
+            start = r;
+        if (changed || start < 0)
+            continue;
+
+        stream_byte(D_BURST_COMMAND, D_SET_ROW);
+        stream_byte(D_BURST_COMMAND, start);
+        stream_byte(D_BURST_COMMAND, r - 1);
+
+        for (uint8_t k = start; k < r; k++) {
+            uint8_t ri = k > 31;
+            uint32_t p = 1 << (k & 31);
             uint8_t c = 0x00;
             if (p & op->write_2[ri])
                 c |= 0xF0;
             if (p & op->write_1[ri])
                 c |= 0x0F;
-
-            d_start_command();
-            d_row(i, i);
-            
-            d_start_data();
-            d_write(c);
+            stream_byte(D_BURST_DATA, c);
         }
+        start = -1;
     }
+
+    d_burst(stream, stream_len);
 }
 
 static column_operations blank;
@@ -91,53 +182,157 @@ static inline bool op_blank(column_operations a) {
 
 void display_render_2_cols(uint8_t i) {
     column_operations op;
+    column screen[2]; // what the pair should show
     uint32_t diff;
 
-    d_start_command();
-    d_col(i / 2, i / 2);
+    freshen(i);
+    overlay_freshen(i);
+
+    for (uint8_t c = 0; c < 2; c++) {
+        screen[c][0] = shadow[i + c][0] | overlay[i + c][0];
+        screen[c][1] = shadow[i + c][1] | overlay[i + c][1];
+    }
 
-    diff = shadow[i][0] ^ live[i][0];
+    diff = screen[0][0] ^ live[i][0];
     op.erase_1[0] = live[i][0] & diff;
-    op.write_1[0] = shadow[i][0] & diff;
+    op.write_1[0] = screen[0][0] & diff;
 
-    diff = shadow[i][1] ^ live[i][1];
+    diff = screen[0][1] ^ live[i][1];
     op.erase_1[1] = live[i][1] & diff;
-    op.write_1[1] = shadow[i][1] & diff;
+    op.write_1[1] = screen[0][1] & diff;
 
-    diff = shadow[i + 1][0] ^ live[i + 1][0];
+    diff = screen[1][0] ^ live[i + 1][0];
     op.erase_2[0] = live[i + 1][0] & diff;
-    op.write_2[0] = shadow[i + 1][0] & diff;
+    op.write_2[0] = screen[1][0] & diff;
 
-    diff = shadow[i + 1][1] ^ live[i + 1][1];
+    diff = screen[1][1] ^ live[i + 1][1];
     op.erase_2[1] = live[i + 1][1] & diff;
-    op.write_2[1] = shadow[i + 1][1] & diff;
+    op.write_2[1] = screen[1][1] & diff;
 
     if (!op_blank(op)) {
         // scan through and mirror columns
         for (int8_t j = 31; j >= 0; j--) {
             if ((1 << j) & op.erase_1[0] || (1 << j) & op.write_1[0])
-                op.write_2[0] |= (1 << j) & shadow[i + 1][0];
+                op.write_2[0] |= (1 << j) & screen[1][0];
             if ((1 << j) & op.erase_1[1] || (1 << j) & op.write_1[1])
-                op.write_2[1] |= (1 << j) & shadow[i + 1][1];
+                op.write_2[1] |= (1 << j) & screen[1][1];
             if ((1 << j) & op.erase_2[0] || (1 << j) & op.write_2[0])
-                op.write_1[0] |= (1 << j) & shadow[i][0];
+                op.write_1[0] |= (1 << j) & screen[0][0];
             if ((1 << j) & op.erase_2[1] || (1 << j) & op.write_2[1])
-                op.write_1[1] |= (1 << j) & shadow[i][1];
+                op.write_1[1] |= (1 << j) & screen[0][1];
         }
 
-        render_columns(&op);
+        render_columns(i, &op);
     }
 
     d_end();
+
+    // the screen now matches the shadow and overlay for this pair
+    live[i][0] = screen[0][0];
+    live[i][1] = screen[0][1];
+    live[i + 1][0] = screen[1][0];
+    live[i + 1][1] = screen[1][1];
+
+    uint32_t bit = 1 << ((i / 2) & 31);
+    dirty[i > 63] &= ~bit;
+
+    if (rolling && persist_frames != DISPLAY_PERSIST_INFINITE) {
+        stale[i > 63] |= bit;
+        // lit pixels still need clearing or aging next time round
+        if (shadow[i][0] | shadow[i][1] | shadow[i + 1][0] | shadow[i + 1][1])
+            dirty[i > 63] |= bit;
+    }
 }
 
-void display_new_frame() {
-    column* temp = live;
-    live = shadow;
-    shadow = temp;
+// Step the sweep on one pair, rendering it only if it is dirty. Called at
+// a steady rate, every pair is visited once per sweep however few are drawn.
+bool display_render_dirty(void) {
+    dirty_cursor = (dirty_cursor + 1) % 64;
+    if (!(dirty[dirty_cursor > 31] & (1 << (dirty_cursor & 31))))
+        return false;
+    display_render_2_cols(dirty_cursor * 2);
+    return true;
+}
+
+// Switch between frame-at-a-time and rolling accumulation, starting over
+void display_rolling(bool r) {
+    if (r == rolling)
+        return;
+    rolling = r;
+    memset(persist, 0, sizeof(persist));
     display_clear();
 }
 
+// Bit-sliced decrement of every non-zero counter in a column
+static inline void age_column(uint8_t col) {
+    column* c = persist[col];
+    for (uint8_t ri = 0; ri < 2; ri++) {
+        uint32_t b0 = c[0][ri], b1 = c[1][ri], b2 = c[2][ri], b3 = c[3][ri];
+        uint32_t borrow = b0 | b1 | b2 | b3;
+
+        c[0][ri] = b0 ^ borrow;
+        borrow &= ~b0;
+        c[1][ri] = b1 ^ borrow;
+        borrow &= ~b1;
+        c[2][ri] = b2 ^ borrow;
+        borrow &= ~b2;
+        c[3][ri] = b3 ^ borrow;
+
+        shadow[col][ri] = c[0][ri] | c[1][ri] | c[2][ri] | c[3][ri];
+    }
+}
+
+static inline void set_age(uint8_t col, uint8_t ri, uint32_t p, uint8_t age) {
+    column* c = persist[col];
+    c[0][ri] = age & 1 ? c[0][ri] | p : c[0][ri] & ~p;
+    c[1][ri] = age & 2 ? c[1][ri] | p : c[1][ri] & ~p;
+    c[2][ri] = age & 4 ? c[2][ri] | p : c[2][ri] & ~p;
+    c[3][ri] = age & 8 ? c[3][ri] | p : c[3][ri] & ~p;
+}
+
+// Carry a pair into the current frame: cleared, kept or aged
+static void freshen(uint8_t col) {
+    uint8_t i = col & ~1;
+    uint32_t bit = 1 << ((i / 2) & 31);
+    if (!(stale[i > 63] & bit))
+        return;
+    stale[i > 63] &= ~bit;
+
+    if (persist_frames == DISPLAY_PERSIST_OFF) {
+        shadow[i][0] = 0;
+        shadow[i][1] = 0;
+        shadow[i + 1][0] = 0;
+        shadow[i + 1][1] = 0;
+    }
+    else {
+        age_column(i);
+        age_column(i + 1);
+    }
+}
+
+void display_persistence(uint8_t frames) {
+    if (frames != DISPLAY_PERSIST_INFINITE && frames > DISPLAY_PERSIST_MAX)
+        frames = DISPLAY_PERSIST_MAX;
+    memset(persist, 0, sizeof(persist));
+    persist_frames = frames;
+}
+
+// After the last pair of a frame is rendered live matches the shadow, so
+// the shadow is carried over in place rather than rebuilt here
+void display_new_frame() {
+    overlay_stale[0] = 0xFFFFFFFF;
+    overlay_stale[1] = 0xFFFFFFFF;
+    dirty[0] |= overlay_used[0];
+    dirty[1] |= overlay_used[1];
+
+    if (rolling || persist_frames == DISPLAY_PERSIST_INFINITE)
+        return;
+
+    // every pair may change, even ones nothing draws to this frame
+    stale[0] = dirty[0] = 0xFFFFFFFF;
+    stale[1] = dirty[1] = 0xFFFFFFFF;
+}
+
 void display_render(void) {
     for (uint8_t i = 128; i > 0 ; i -= 2) {
         display_render_2_cols(128 - i);
@@ -146,7 +341,29 @@ void display_render(void) {
     display_new_frame();
 }
 
+// Blank the screen in hardware and forget what was on it
+void display_reset(void) {
+    d_start_command();
+    d_options(D_OPTION_FILL);
+    d_draw_rect(0, 0, 63, 63, 0x00);
+    d_end();
+
+    memset(shadow, 0, sizeof(shadow));
+    memset(live, 0, sizeof(live));
+    memset(persist, 0, sizeof(persist));
+    memset(overlay, 0, sizeof(overlay));
+    dirty[0] = 0;
+    dirty[1] = 0;
+    stale[0] = 0;
+    stale[1] = 0;
+    overlay_used[0] = 0;
+    overlay_used[1] = 0;
+    overlay_stale[0] = 0;
+    overlay_stale[1] = 0;
+}
+
 uint8_t display_peek(uint8_t col, uint8_t row) {
+    freshen(col);
     if (row > 31)
         return (shadow[col][1] & (1 << (row - 32))) > 0;
     else
@@ -154,13 +371,39 @@ uint8_t display_peek(uint8_t col, uint8_t row) {
 }
 
 void display_clear(void) {
-    for (uint8_t i = 0; i < 128; i++) {
-        shadow[i][0] = 0;
-        shadow[i][1] = 0;
+    memset(shadow, 0, sizeof(shadow));
+    stale[0] = 0;
+    stale[1] = 0;
+    dirty[0] = 0xFFFFFFFF;
+    dirty[1] = 0xFFFFFFFF;
+}
+
+void display_blit(uint8_t col, const column c) {
+    freshen(col);
+    for (uint8_t ri = 0; ri < 2; ri++) {
+        if (!c[ri])
+            continue;
+        shadow[col][ri] |= c[ri];
+        mark_dirty(col);
+        if (persist_frames != DISPLAY_PERSIST_OFF &&
+                persist_frames != DISPLAY_PERSIST_INFINITE)
+            set_age(col, ri, c[ri], persist_frames);
     }
 }
 
+// Draw over the shadow, outside persistence, until the next frame
+void display_overlay(uint8_t col, const column c) {
+    overlay_freshen(col);
+    if (!(c[0] | c[1]))
+        return;
+    overlay[col][0] |= c[0];
+    overlay[col][1] |= c[1];
+    overlay_used[col > 63] |= 1 << ((col / 2) & 31);
+    mark_dirty(col);
+}
+
 void display_poke(uint8_t col, uint8_t row, uint8_t set) {
+    freshen(col);
     uint8_t ri = row > 31;
     if (ri)
         row -= 32;
@@ -168,4 +411,9 @@ void display_poke(uint8_t col, uint8_t row, uint8_t set) {
         shadow[col][ri] |= (1 << row);
     else
         shadow[col][ri] &= ~(1 << row); 
+    mark_dirty(col);
+
+    if (persist_frames != DISPLAY_PERSIST_OFF &&
+            persist_frames != DISPLAY_PERSIST_INFINITE)
+        set_age(col, ri, 1 << row, set ? persist_frames : 0);
 }
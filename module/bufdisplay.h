@@ -1,13 +1,56 @@
 #ifndef BUFDISPLAY_H
 #define BUFDISPLAY_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#define DISPLAY_PERSIST_BITS     4
+#define DISPLAY_PERSIST_MAX      ((1 << DISPLAY_PERSIST_BITS) - 1)
+#define DISPLAY_PERSIST_OFF      0
+#define DISPLAY_PERSIST_INFINITE 0xFF
+
+/*
+ * Data type: column
+ * Each bit represents a set pixel
+ *
+ * uint64_t won't work on AVR32
+ *                                                                           */
+typedef uint32_t column[2];
+/*                               LSb    MSb
+ *                     [0] = row   0 to 31 
+ *                     [1] = row  32 to 63
+ *                                                                           */
+
+static inline void column_set(column c, uint8_t row) {
+    c[row > 31] |= 1 << (row & 31);
+}
+
+// set rows lo to hi inclusive
+static inline void column_fill(column c, uint8_t lo, uint8_t hi) {
+    for (uint8_t ri = 0; ri < 2; ri++) {
+        int8_t a = lo - ri * 32;
+        int8_t b = hi - ri * 32;
+        if (b < 0 || a > 31)
+            continue;
+        if (a < 0)
+            a = 0;
+        if (b > 31)
+            b = 31;
+        c[ri] |= (0xFFFFFFFF >> (31 - b)) & (0xFFFFFFFF << a);
+    }
+}
+
 uint8_t display_peek(uint8_t, uint8_t);
 void display_poke(uint8_t, uint8_t, uint8_t);
+void display_blit(uint8_t, const column);
+void display_overlay(uint8_t, const column);
 void display_render(void);
 void display_clear(void);
+void display_reset(void);
 void display_new_frame(void);
 void display_render_2_cols(uint8_t);
+bool display_render_dirty(void);
+void display_rolling(bool);
+void display_persistence(uint8_t);
 
 #endif
@@ -65,6 +65,17 @@ CSRCS = \
 	../module/scope.c					\
 	../module/display.c					\
 	../module/bufdisplay.c					\
+	../module/mask.c					\
+	../module/trigger.c					\
+	../module/timebase.c					\
+	../module/waterfall.c					\
+	../module/follower.c					\
+	../module/dac.c						\
+	../module/gate.c					\
+	../module/reference.c					\
+	../module/autoset.c					\
+	../module/text.c					\
+	../module/readout.c					\
 	../libavr32/src/adc.c					\
 	../libavr32/src/events.c				\
 	../libavr32/src/euclidean/euclidean.c			\
@@ -0,0 +1,61 @@
+/*
+ * dac.c
+ *
+ * Queued writes to the two daisy chained 12-bit DACs
+ *
+ * The DACs share the SPI bus with the ADC and OLED, so dac_set() only
+ * records the value. dac_flush() sends whatever changed, and is called
+ * from the sample interrupt between ADC and display traffic.
+ *                                                                          */
+
+#include "dac.h"
+
+#include "conf_board.h"
+#include "spi.h"
+
+// one transfer updates a channel on each chip: { 2, 0 } then { 3, 1 }
+static const uint8_t pair_command[2] = { 0x31, 0x38 };
+
+static uint16_t value[DAC_CHANNELS];
+static volatile uint8_t dirty = 0;
+
+static inline void write_value(uint16_t v) {
+    spi_write(DAC_SPI, v >> 4);
+    spi_write(DAC_SPI, v << 4);
+}
+
+void dac_init(void) {
+    // setup daisy chain for two dacs
+    spi_selectChip(DAC_SPI, DAC_SPI_NPCS);
+    spi_write(DAC_SPI, 0x80);
+    spi_write(DAC_SPI, 0xff);
+    spi_write(DAC_SPI, 0xff);
+    spi_unselectChip(DAC_SPI, DAC_SPI_NPCS);
+
+    dirty = (1 << DAC_CHANNELS) - 1;
+    dac_flush();
+}
+
+void dac_set(uint8_t ch, uint16_t v) {
+    if (v > DAC_MAX)
+        v = DAC_MAX;
+    if (value[ch] == v)
+        return;
+    value[ch] = v;
+    dirty |= 1 << ch;
+}
+
+void dac_flush(void) {
+    for (uint8_t p = 0; p < 2; p++) {
+        if (!(dirty & ((1 << p) | (1 << (p + 2)))))
+            continue;
+
+        spi_selectChip(DAC_SPI, DAC_SPI_NPCS);
+        spi_write(DAC_SPI, pair_command[p]);
+        write_value(value[p + 2]);
+        spi_write(DAC_SPI, pair_command[p]);
+        write_value(value[p]);
+        spi_unselectChip(DAC_SPI, DAC_SPI_NPCS);
+    }
+    dirty = 0;
+}
@@ -0,0 +1,13 @@
+#ifndef DAC_H
+#define DAC_H
+
+#include <stdint.h>
+
+#define DAC_CHANNELS 4
+#define DAC_MAX 4095
+
+void dac_init(void);
+void dac_set(uint8_t, uint16_t);
+void dac_flush(void);
+
+#endif
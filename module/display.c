@@ -51,3 +51,34 @@ void d_start_data(void) {
         select_data();
 }
 
+
+/*
+ * Send an encoded command stream back to back, feeding the TX holding
+ * register as soon as it empties. DC only changes between runs, once the
+ * shifter has drained, so no byte is clocked out under the wrong level.
+ */
+void d_burst(const uint8_t* buf, uint16_t len) {
+    volatile avr32_spi_t* spi = OLED_SPI;
+    uint16_t i = 0;
+
+    while (i < len) {
+        uint8_t hdr = buf[i++];
+        uint8_t n = hdr & D_BURST_LENGTH;
+        bool data = (hdr & D_BURST_DATA) != 0;
+
+        if (!chip_selected)
+            select_chip();
+        if (data != data_selected) {
+            while (!(spi->sr & AVR32_SPI_SR_TXEMPTY_MASK));
+            if (data)
+                select_data();
+            else
+                select_command();
+        }
+
+        while (n--) {
+            while (!(spi->sr & AVR32_SPI_SR_TDRE_MASK));
+            spi->tdr = buf[i++] << AVR32_SPI_TDR_TD_OFFSET;
+        }
+    }
+}
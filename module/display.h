@@ -26,10 +26,20 @@
 #define D_SCROLL_128 2
 #define D_SCROLL_256 3
 
+#define D_SET_COL          0x15
+#define D_SET_ROW          0x75
+
+// d_burst() stream run headers: DC level and run length
+#define D_BURST_COMMAND    0x00
+#define D_BURST_DATA       0x80
+#define D_BURST_LENGTH     0x7F
+
 #define d_write(x) ( spi_write(OLED_SPI, x) )
 
 void d_start_command(void);
 
+void d_burst(const uint8_t*, uint16_t);
+
 void d_end(void);
 
 void d_start_data(void);
@@ -42,14 +52,14 @@ void d_assert_chip(void);
 
 static inline void d_col(uint8_t start, uint8_t end) {
     d_assert_chip();
-    d_write(0x15);
+    d_write(D_SET_COL);
     d_write(start);
     d_write(end);
 }
 
 static inline void d_row(uint8_t start, uint8_t end) {
     d_assert_chip();
-    d_write(0x75);
+    d_write(D_SET_ROW);
     d_write(start);
     d_write(end);
 }
@@ -0,0 +1,151 @@
+/*
+ * follower.c
+ *
+ * I2C follower, so a teletype can drive the scope and stream values to it
+ *
+ * follower_receive() runs from the TWI interrupt and only copies each
+ * message into a single producer, single consumer queue. The main loop
+ * drains the queue with follower_poll(), so bus traffic never holds up
+ * the sample interrupt.
+ *                                                                          */
+
+#include "follower.h"
+#include "autoset.h"
+#include "bufdisplay.h"
+#include "gate.h"
+#include "mask.h"
+#include "readout.h"
+#include "reference.h"
+#include "scope.h"
+#include "trigger.h"
+
+#include "i2c.h"
+
+#include <string.h> // memcpy()
+
+typedef struct {
+    uint8_t len;
+    uint8_t data[FOLLOWER_MSG_SIZE];
+} message;
+
+static message queue[FOLLOWER_QUEUE_SIZE];
+static volatile uint8_t head = 0; // written by the receiver only
+static volatile uint8_t tail = 0; // written by follower_poll() only
+
+void follower_init(void) {
+    process_ii = &follower_receive;
+    init_i2c_slave(FOLLOWER_II_ADDR);
+}
+
+// Bus side: drop the message rather than wait if the queue is full
+void follower_receive(uint8_t* data, uint8_t len) {
+    uint8_t next = (head + 1) % FOLLOWER_QUEUE_SIZE;
+    if (next == tail || len == 0)
+        return;
+    if (len > FOLLOWER_MSG_SIZE)
+        len = FOLLOWER_MSG_SIZE;
+
+    memcpy(queue[head].data, data, len);
+    queue[head].len = len;
+    head = next;
+}
+
+static inline int16_t arg16(const message* m, uint8_t i) {
+    return (int16_t)((m->data[i] << 8) | m->data[i + 1]);
+}
+
+static void process(const message* m) {
+    const uint8_t* d = m->data;
+
+    switch (d[0]) {
+        case FOLLOWER_ZOOM:
+            if (m->len >= 3)
+                scope_zoom(arg16(m, 1));
+            break;
+        case FOLLOWER_TRIGGER_LEVEL:
+            if (m->len >= 3)
+                trigger_set_level((uint16_t)arg16(m, 1));
+            break;
+        case FOLLOWER_TRIGGER_EDGE:
+            if (m->len >= 2 && d[1] <= TRIGGER_FALLING)
+                trigger_set_edge(d[1]);
+            break;
+        case FOLLOWER_TRACE:
+            if (m->len >= 2 && d[1] <= SCOPE_TRACE_DERIVATIVE)
+                scope_trace_select(d[1]);
+            break;
+        case FOLLOWER_MODE:
+            if (m->len >= 2 && d[1] <= SCOPE_MODE_PLOT)
+                scope_mode(d[1]);
+            break;
+        case FOLLOWER_PERSISTENCE:
+            if (m->len >= 2)
+                scope_persistence(d[1]);
+            break;
+        case FOLLOWER_SEGMENTS:
+            if (m->len >= 2)
+                scope_segments(d[1]);
+            break;
+        case FOLLOWER_SEGMENT_VIEW:
+            if (m->len >= 2)
+                scope_segment_view((int8_t)d[1]);
+            break;
+        case FOLLOWER_MASK_LEARN:
+            if (m->len >= 2)
+                mask_learn(d[1]);
+            break;
+        case FOLLOWER_MASK_CLEAR:
+            mask_clear();
+            break;
+        case FOLLOWER_MASK_FREEZE:
+            if (m->len >= 2)
+                mask_freeze_on_fail(d[1]);
+            break;
+        case FOLLOWER_HISTOGRAM_RESET:
+            scope_histogram_reset();
+            break;
+        case FOLLOWER_GATE_MODE:
+            if (m->len >= 2 && d[1] <= GATE_TRIGGER)
+                gate_set_mode(d[1]);
+            break;
+        case FOLLOWER_SAMPLE_HOLD:
+            if (m->len >= 2)
+                gate_sample_hold(d[1]);
+            break;
+        case FOLLOWER_REFERENCE_SAVE:
+            if (m->len >= 2)
+                reference_save(d[1]);
+            break;
+        case FOLLOWER_REFERENCE_SHOW:
+            if (m->len >= 2)
+                reference_show((int8_t)d[1]);
+            break;
+        case FOLLOWER_PLOT:
+            for (uint8_t i = 1; i + 1 < m->len; i += 2)
+                scope_plot(arg16(m, i));
+            break;
+        case FOLLOWER_PLOT_CLEAR:
+            scope_plot_clear();
+            break;
+        case FOLLOWER_AUTOSET:
+            autoset_start();
+            break;
+        case FOLLOWER_READOUT:
+            if (m->len >= 2)
+                readout_show(d[1]);
+            break;
+        case FOLLOWER_MASK_RESET:
+            mask_reset_counts();
+            break;
+        default:
+            break;
+    }
+}
+
+// Main loop side
+void follower_poll(void) {
+    while (tail != head) {
+        process(&queue[tail]);
+        tail = (tail + 1) % FOLLOWER_QUEUE_SIZE;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef FOLLOWER_H
+#define FOLLOWER_H
+
+#include <stdint.h>
+
+#define FOLLOWER_II_ADDR 0x5A // 7-bit, clear of the reserved 0x78 - 0x7F
+
+// Commands, first byte of each message. 16-bit arguments are big endian.
+#define FOLLOWER_ZOOM            0x00 // s16 zoom
+#define FOLLOWER_TRIGGER_LEVEL   0x01 // u16 level
+#define FOLLOWER_TRIGGER_EDGE    0x02 // u8 trigger_edge
+#define FOLLOWER_TRACE           0x03 // u8 scope_trace
+#define FOLLOWER_MODE            0x04 // u8 scope_display_mode
+#define FOLLOWER_PERSISTENCE     0x05 // u8 frames
+#define FOLLOWER_SEGMENTS        0x06 // u8 count
+#define FOLLOWER_SEGMENT_VIEW    0x07 // s8 segment, -1 overlays
+#define FOLLOWER_MASK_LEARN      0x08 // u8 tolerance in rows
+#define FOLLOWER_MASK_CLEAR      0x09
+#define FOLLOWER_MASK_FREEZE     0x0A // u8 freeze on failure
+#define FOLLOWER_HISTOGRAM_RESET 0x0B
+#define FOLLOWER_GATE_MODE       0x0C // u8 gate_mode
+#define FOLLOWER_SAMPLE_HOLD     0x0D // u8 sample and hold on trigger
+#define FOLLOWER_REFERENCE_SAVE  0x0E // u8 slot
+#define FOLLOWER_REFERENCE_SHOW  0x0F // s8 slot, -1 hides
+#define FOLLOWER_PLOT            0x10 // s16 values...
+#define FOLLOWER_PLOT_CLEAR      0x11
+#define FOLLOWER_AUTOSET         0x12
+#define FOLLOWER_READOUT         0x13 // u8 show readouts
+#define FOLLOWER_MASK_RESET      0x14 // restart the pass/fail counts
+
+#define FOLLOWER_QUEUE_SIZE 16 // messages, power of two
+#define FOLLOWER_MSG_SIZE   32
+
+void follower_init(void);
+void follower_receive(uint8_t*, uint8_t);
+void follower_poll(void);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * gate.c
+ *
+ * Gate, trigger and sample and hold outputs driven by the trigger engine
+ *
+ * Runs once per sample, so an output follows its trigger within one
+ * sample period once the DAC queue is flushed.
+ *                                                                          */
+
+#include "gate.h"
+#include "dac.h"
+#include "telescope.h"
+#include "timebase.h"
+#include "trigger.h"
+
+static gate_mode mode = GATE_OFF;
+static bool sample_hold = false;
+static bool high = false;
+static uint32_t pulse = 0; // samples left in the trigger pulse
+
+void gate_set_mode(gate_mode m) {
+    mode = m;
+    pulse = 0;
+    high = false;
+    dac_set(GATE_CHANNEL, 0);
+}
+
+void gate_sample_hold(bool on) {
+    sample_hold = on;
+}
+
+void gate_process(uint16_t sample, bool triggered) {
+    if (triggered && sample_hold)
+        dac_set(GATE_SH_CHANNEL, sample);
+
+    switch (mode) {
+        case GATE_COMPARATOR:
+            if (!high && sample >= trigger_get_level())
+                high = true;
+            else if (high && sample + TRIGGER_HYSTERESIS < trigger_get_level())
+                high = false;
+            break;
+        case GATE_TRIGGER:
+            if (triggered)
+                pulse = timebase_rate() * GATE_TRIGGER_MS / 1000 + 1;
+            high = pulse > 0;
+            if (pulse)
+                pulse--;
+            break;
+        default:
+            return;
+    }
+
+    dac_set(GATE_CHANNEL, high ? GATE_HIGH : 0);
+}
@@ -0,0 +1,17 @@
+#ifndef GATE_H
+#define GATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    GATE_OFF,
+    GATE_COMPARATOR, // high while the input is above the trigger level
+    GATE_TRIGGER     // GATE_TRIGGER_MS pulse on each scope trigger
+} gate_mode;
+
+void gate_set_mode(gate_mode);
+void gate_sample_hold(bool);
+void gate_process(uint16_t, bool);
+
+#endif
@@ -30,9 +30,17 @@
 
 // this
 #include "conf_board.h"
+#include "autoset.h"
+#include "dac.h"
 #include "display.h"
+#include "follower.h"
+#include "readout.h"
+#include "reference.h"
 #include "scope.h"
+#include "text.h"
 #include "telescope.h"
+#include "timebase.h"
+#include "waterfall.h"
 
 static uint16_t adc[4];
 
@@ -124,7 +132,9 @@ static void sample_callback(void) {
         d_end();
 #endif
     adc_convert(&adc);
-    scope_process_sample(adc[0]);
+    scope_process_sample(adc[SCOPE_CHANNEL_A], adc[SCOPE_CHANNEL_B]);
+    // while the OLED is deselected
+    dac_flush();
 
     uint16_t knob = adc[1] / 205;
 
@@ -142,7 +152,7 @@ static void sample_callback(void) {
 
 #ifndef TWO_TIMERS
     static uint32_t count = 0;
-    count = (count + 1) % DISPLAY_DIVISOR;
+    count = (count + 1) % timebase_divisor();
     if (count == 0)
         scope_draw();
 #endif
@@ -188,7 +198,7 @@ void timer_init(void) {
 
     INTC_register_interrupt(&sample_callback, AVR32_TC_IRQ0, AVR32_INTC_INT0);
     tc_init_waveform(APP_TC, &waveform_opt_1);
-    tc_write_rc(APP_TC, 0, (FCPU_HZ / SAMPLE_RATE));
+    tc_write_rc(APP_TC, 0, TIMEBASE_RC);
     tc_configure_interrupts(&AVR32_TC, 0, &tc_interrupt_1);
     tc_start(APP_TC, 0);
 #ifdef TWO_TIMERS
@@ -223,7 +233,7 @@ void timer_init(void) {
     };
     INTC_register_interrupt(&display_callback, AVR32_TC_IRQ1, AVR32_INTC_INT1);
     tc_init_waveform(APP_TC, &waveform_opt_2);
-    tc_write_rc(APP_TC, 1, (sysclk_get_pba_hz() / DISPLAY_RATE));
+    tc_write_rc(APP_TC, 1, (TIMEBASE_CLOCK_HZ / DISPLAY_RATE));
     tc_configure_interrupts(&AVR32_TC, 1, &tc_interrupt_2);
     tc_start(APP_TC, 1);
 #endif
@@ -239,24 +249,23 @@ int main(void) {
 
     print_dbg("\r\n\r\n// telescope! /////////////////////////////// ");
 
-    // setup daisy chain for two dacs
-#if 0
-    spi_selectChip(DAC_SPI, DAC_SPI_NPCS);
-    spi_write(DAC_SPI, 0x80);
-    spi_write(DAC_SPI, 0xff);
-    spi_write(DAC_SPI, 0xff);
-    spi_unselectChip(DAC_SPI, DAC_SPI_NPCS);
-#endif
-
+    dac_init();
+    text_init();
 
     scope_init();
 
     irq_initialize_vectors();
     Disable_global_interrupt();
     timer_init();
+    follower_init();
     Enable_global_interrupt();
     cpu_irq_enable();
 
     while(1) {
+        follower_poll();
+        reference_poll();
+        autoset_poll();
+        readout_poll();
+        waterfall_poll();
     }
 }
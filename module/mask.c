@@ -0,0 +1,187 @@
+/*
+ * mask.c
+ *
+ * Mask / limit testing
+ *
+ * A reference trace is learned over a few frames and widened by a tolerance
+ * into a per-column band of allowed rows. Each captured column is then
+ * tested word-parallel: any trace pixel outside the band is a violation.
+ *                                                                          */
+
+#include "mask.h"
+
+typedef enum {
+    MASK_OFF,
+    MASK_LEARNING,
+    MASK_TESTING
+} mask_state;
+
+static column mask[128];
+static mask_state state = MASK_OFF;
+static uint8_t tolerance = 0;
+static uint8_t learn_frames = 0;
+
+static bool freeze_on_fail = false;
+static bool frozen = false;
+static bool frame_failed = false;
+
+static uint32_t frames_tested = 0;
+static uint32_t frames_failed = 0;
+
+/*
+ * Requests from outside the sample interrupt, applied at the next frame
+ * by mask_start_frame() so the ISR never sees a half-made change
+ */
+typedef enum {
+    MASK_REQUEST_NONE,
+    MASK_REQUEST_LEARN,
+    MASK_REQUEST_CLEAR
+} mask_request;
+
+static volatile mask_request request = MASK_REQUEST_NONE;
+static volatile uint8_t request_tolerance = 0;
+static volatile bool next_freeze = false;
+static volatile bool reset_counts = false;
+
+static void start_learning(uint8_t tol) {
+    for (uint8_t i = 0; i < 128; i++) {
+        mask[i][0] = 0;
+        mask[i][1] = 0;
+    }
+    tolerance = tol;
+    learn_frames = MASK_LEARN_FRAMES;
+    frames_tested = 0;
+    frames_failed = 0;
+    frame_failed = false;
+    frozen = false;
+    state = MASK_LEARNING;
+}
+
+// Takes effect at the next frame
+void mask_learn(uint8_t tol) {
+    request_tolerance = tol;
+    request = MASK_REQUEST_LEARN;
+}
+
+// Takes effect at the next frame
+void mask_clear(void) {
+    request = MASK_REQUEST_CLEAR;
+}
+
+// Takes effect at the next frame
+void mask_freeze_on_fail(bool f) {
+    next_freeze = f;
+}
+
+// Restart the pass/fail counts without relearning, at the next frame
+void mask_reset_counts(void) {
+    reset_counts = true;
+}
+
+// Called at the start of each frame, before mask_frozen() is checked
+void mask_start_frame(void) {
+    freeze_on_fail = next_freeze;
+    if (!freeze_on_fail)
+        frozen = false;
+
+    if (request == MASK_REQUEST_LEARN)
+        start_learning(request_tolerance);
+    else if (request == MASK_REQUEST_CLEAR) {
+        state = MASK_OFF;
+        frozen = false;
+    }
+    request = MASK_REQUEST_NONE;
+
+    if (reset_counts) {
+        frames_tested = 0;
+        frames_failed = 0;
+        reset_counts = false;
+    }
+}
+
+bool mask_frozen(void) {
+    return frozen;
+}
+
+bool mask_testing(void) {
+    return state == MASK_TESTING;
+}
+
+uint32_t mask_frames_tested(void) {
+    return frames_tested;
+}
+
+uint32_t mask_frames_failed(void) {
+    return frames_failed;
+}
+
+// Returns true if the trace column strays outside the mask
+bool mask_test(uint8_t col, const column trace) {
+    if (state == MASK_LEARNING) {
+        for (uint8_t row = 0; row < 64; row++) {
+            if (trace[row > 31] & (1 << (row & 31))) {
+                uint8_t lo = row > tolerance ? row - tolerance : 0;
+                uint8_t hi = row + tolerance < 63 ? row + tolerance : 63;
+                column_fill(mask[col], lo, hi);
+            }
+        }
+        return false;
+    }
+
+    if (state != MASK_TESTING)
+        return false;
+
+    if ((trace[0] & ~mask[col][0]) | (trace[1] & ~mask[col][1])) {
+        frame_failed = true;
+        return true;
+    }
+    return false;
+}
+
+// Draw the band edges, or the whole forbidden region of a failing column
+void mask_overlay(uint8_t col, bool failed) {
+    if (state != MASK_TESTING)
+        return;
+
+    column c = { 0, 0 };
+    if (failed) {
+        c[0] = ~mask[col][0];
+        c[1] = ~mask[col][1];
+    }
+    else {
+        // rows in the mask with an unmasked neighbour
+        uint32_t up0 = (mask[col][0] >> 1) | (mask[col][1] << 31);
+        uint32_t up1 = (mask[col][1] >> 1) | 0x80000000;
+        uint32_t dn0 = (mask[col][0] << 1) | 1;
+        uint32_t dn1 = (mask[col][1] << 1) | (mask[col][0] >> 31);
+        c[0] = mask[col][0] & ~(up0 & dn0);
+        c[1] = mask[col][1] & ~(up1 & dn1);
+    }
+    display_overlay(col, c);
+}
+
+// A frame that redrew an already tested capture is neither learned from
+// nor counted, so each capture is counted once however long it is shown
+void mask_end_frame(bool published) {
+    if (!published) {
+        frame_failed = false;
+        return;
+    }
+
+    if (state == MASK_LEARNING) {
+        if (--learn_frames == 0)
+            state = MASK_TESTING;
+        return;
+    }
+
+    if (state != MASK_TESTING)
+        return;
+
+    frames_tested++;
+    if (frame_failed) {
+        frames_failed++;
+        if (freeze_on_fail)
+            frozen = true;
+    }
+    frame_failed = false;
+}
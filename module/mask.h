@@ -0,0 +1,24 @@
+#ifndef MASK_H
+#define MASK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bufdisplay.h"
+
+#define MASK_LEARN_FRAMES 8
+
+void mask_learn(uint8_t);
+void mask_clear(void);
+void mask_freeze_on_fail(bool);
+void mask_start_frame(void);
+void mask_reset_counts(void);
+bool mask_test(uint8_t, const column);
+void mask_overlay(uint8_t, bool);
+void mask_end_frame(bool);
+bool mask_frozen(void);
+bool mask_testing(void);
+uint32_t mask_frames_tested(void);
+uint32_t mask_frames_failed(void);
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * readout.c
+ *
+ * Time/div, V/div, frequency, segment and mask test readouts
+ *
+ * The main loop formats the readouts from the current scope state and
+ * only lays out a new text layer when one of the strings changes. Each
+ * readout has a fixed slot so a change in one leaves the others' columns
+ * alone.
+ *                                                                          */
+
+#include "readout.h"
+#include "mask.h"
+#include "scope.h"
+#include "telescope.h"
+#include "text.h"
+#include "timebase.h"
+
+#include <string.h> // strcmp(), strcpy()
+
+#define READOUT_LEN 28
+
+static bool shown = true;
+static bool drawn = false;
+static char time_div[READOUT_LEN];
+static char volts_div[READOUT_LEN];
+static char freq[READOUT_LEN];
+static char mask_counts[READOUT_LEN];
+static char segment[READOUT_LEN];
+
+void readout_show(bool s) {
+    shown = s;
+    drawn = false;
+}
+
+static char* put_uint(char* p, uint32_t v) {
+    char digits[10];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n)
+        *p++ = digits[--n];
+    return p;
+}
+
+// Three significant figures of v small units, switching to big = 1000 small
+static void format(char* buf, uint32_t v, const char* small, const char* big) {
+    char* p = buf;
+    const char* unit = small;
+
+    if (v < 1000)
+        p = put_uint(p, v);
+    else {
+        unit = big;
+        p = put_uint(p, v / 1000);
+        if (v < 100000) {
+            *p++ = '.';
+            if (v < 10000) {
+                *p++ = '0' + (v / 100) % 10;
+                *p++ = '0' + (v / 10) % 10;
+            }
+            else
+                *p++ = '0' + (v / 100) % 10;
+        }
+    }
+    strcpy(p, unit);
+}
+
+static void format_time(char* buf) {
+    uint32_t samples = scope_zoom_span(scope_get_zoom()) * SCOPE_DIV_COLS;
+    uint32_t us = (samples * (1000000 / SAMPLE_RATE)) / 128;
+    if (us < 1000000)
+        format(buf, us, "us", "ms");
+    else
+        format(buf, us / 1000, "ms", "s");
+}
+
+static void format_volts(char* buf) {
+    uint32_t mv = (SCOPE_FULL_SCALE_MV * SCOPE_DIV_ROWS) / 64 / scope_get_gain();
+    format(buf, mv, "mV", "V");
+}
+
+static void format_freq(char* buf) {
+    uint32_t interval = scope_trigger_interval();
+    if (interval == 0) {
+        strcpy(buf, "--Hz");
+        return;
+    }
+    uint32_t rate = timebase_rate();
+    uint32_t mhz = (rate * 1000) / interval;
+    if (mhz < 1000000)
+        format(buf, mhz, "mHz", "Hz");
+    else
+        format(buf, mhz / 1000, "Hz", "kHz");
+}
+
+// Segments captured, or the one shown and how long before the newest its
+// trigger came
+static void format_segment(char* buf) {
+    char* p = buf;
+    uint8_t n = scope_segments_captured();
+    int8_t view = scope_get_segment_view();
+
+    if (scope_get_mode() != SCOPE_MODE_SEGMENTS) {
+        buf[0] = '\0';
+        return;
+    }
+    if (view == SCOPE_SEGMENT_OVERLAY || n == 0) {
+        p = put_uint(p, n);
+        strcpy(p, " segs");
+        return;
+    }
+
+    strcpy(p, "seg ");
+    p = put_uint(p + 4, view);
+    *p++ = '/';
+    p = put_uint(p, n);
+    *p++ = ' ';
+    *p++ = '-';
+
+    uint32_t dt = scope_segment_time(0) - scope_segment_time(view);
+    uint64_t us = ((uint64_t)dt * 1000000) / timebase_rate();
+    if (us < 1000000)
+        format(p, us, "us", "ms");
+    else
+        format(p, us / 1000, "ms", "s");
+}
+
+// Failed and tested frames, for unattended soak tests
+static void format_mask(char* buf) {
+    if (!mask_testing()) {
+        buf[0] = '\0';
+        return;
+    }
+    char* p = buf;
+    strcpy(p, "fail ");
+    p = put_uint(p + 5, mask_frames_failed());
+    *p++ = '/';
+    p = put_uint(p, mask_frames_tested());
+    *p = '\0';
+}
+
+// Returns true if the string changed
+static bool update(char* s, void (*fmt)(char*)) {
+    char buf[READOUT_LEN];
+    fmt(buf);
+    if (strcmp(buf, s) == 0)
+        return false;
+    strcpy(s, buf);
+    return true;
+}
+
+void readout_poll(void) {
+    bool changed = !drawn;
+    changed |= update(time_div, format_time);
+    changed |= update(volts_div, format_volts);
+    changed |= update(freq, format_freq);
+    changed |= update(mask_counts, format_mask);
+    changed |= update(segment, format_segment);
+
+    if (!changed)
+        return;
+    // the last layer hasn't been shown yet, try again next time
+    if (!text_begin()) {
+        drawn = false;
+        return;
+    }
+
+    if (shown) {
+        text_print(READOUT_TIME_COL, READOUT_ROW, time_div);
+        text_print(READOUT_VOLTS_COL, READOUT_ROW, volts_div);
+        text_print(READOUT_FREQ_COL, READOUT_ROW, freq);
+        text_print(0, READOUT_SEGMENT_ROW, segment);
+        text_print(0, READOUT_MASK_ROW, mask_counts);
+    }
+    text_commit();
+    drawn = true;
+}
@@ -0,0 +1,16 @@
+#ifndef READOUT_H
+#define READOUT_H
+
+#include <stdbool.h>
+
+#define READOUT_ROW 0
+#define READOUT_TIME_COL 0
+#define READOUT_VOLTS_COL 43
+#define READOUT_FREQ_COL 86
+#define READOUT_MASK_ROW 56
+#define READOUT_SEGMENT_ROW 48
+
+void readout_show(bool);
+void readout_poll(void);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * reference.c
+ *
+ * Reference traces kept in internal flash
+ *
+ * Saving captures the next frame's trace columns into RAM from the draw
+ * tick, then the main loop programs them into flash a page at a time.
+ * Recalled traces are overlaid straight out of flash.
+ *                                                                          */
+
+#include "reference.h"
+
+#include "flashc.h"
+
+#include <stdbool.h>
+
+#define REFERENCE_MAGIC 0x54524345 // "TRCE"
+
+typedef struct {
+    column trace[REFERENCE_SLOTS][128];
+    uint32_t magic[REFERENCE_SLOTS];
+} reference_store;
+
+__attribute__((__section__(".flash_nvram")))
+static reference_store store;
+
+typedef enum {
+    REF_IDLE,
+    REF_ARMED,     // waiting for column 0
+    REF_CAPTURING,
+    REF_INVALIDATING, // main loop clears the slot's magic
+    REF_WRITING,      // then programs the pages
+    REF_VALIDATING    // and only then writes the magic back
+} reference_state;
+
+static column staging[128];
+static volatile reference_state state = REF_IDLE;
+static uint8_t save_slot = 0;
+static uint16_t write_offset = 0;
+static int8_t show_slot = REFERENCE_NONE;
+
+// Ignored while a save is still in progress
+void reference_save(uint8_t slot) {
+    if (slot >= REFERENCE_SLOTS || state != REF_IDLE)
+        return;
+    save_slot = slot;
+    state = REF_ARMED;
+}
+
+void reference_show(int8_t slot) {
+    if (slot != REFERENCE_NONE && (slot < 0 || slot >= REFERENCE_SLOTS))
+        return;
+    show_slot = slot;
+}
+
+void reference_capture(uint8_t col, const column trace) {
+    if (state == REF_ARMED && col == 0)
+        state = REF_CAPTURING;
+    if (state != REF_CAPTURING)
+        return;
+
+    staging[col][0] = trace[0];
+    staging[col][1] = trace[1];
+
+    if (col == 127)
+        state = REF_INVALIDATING;
+}
+
+void reference_overlay(uint8_t col) {
+    if (show_slot == REFERENCE_NONE ||
+            store.magic[show_slot] != REFERENCE_MAGIC ||
+            (state >= REF_INVALIDATING && show_slot == save_slot))
+        return;
+    display_overlay(col, store.trace[show_slot][col]);
+}
+
+// One flash page per call, so the flash is only held for a page at a time.
+// The magic is cleared before the data and set after it, so a save cut
+// short by power loss leaves an empty slot rather than a torn trace.
+void reference_poll(void) {
+    uint32_t magic;
+    uint16_t n;
+
+    switch (state) {
+        case REF_INVALIDATING:
+            magic = 0;
+            flashc_memcpy(&store.magic[save_slot], &magic, sizeof(magic), true);
+            write_offset = 0;
+            state = REF_WRITING;
+            break;
+
+        case REF_WRITING:
+            n = sizeof(staging) - write_offset;
+            if (n > AVR32_FLASHC_PAGE_SIZE)
+                n = AVR32_FLASHC_PAGE_SIZE;
+            flashc_memcpy((uint8_t*)store.trace[save_slot] + write_offset,
+                          (uint8_t*)staging + write_offset, n, true);
+            write_offset += n;
+            if (write_offset >= sizeof(staging))
+                state = REF_VALIDATING;
+            break;
+
+        case REF_VALIDATING:
+            magic = REFERENCE_MAGIC;
+            flashc_memcpy(&store.magic[save_slot], &magic, sizeof(magic), true);
+            state = REF_IDLE;
+            break;
+
+        default:
+            break;
+    }
+}
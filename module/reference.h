@@ -0,0 +1,17 @@
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <stdint.h>
+
+#include "bufdisplay.h"
+
+#define REFERENCE_SLOTS 8
+#define REFERENCE_NONE -1
+
+void reference_save(uint8_t);
+void reference_show(int8_t);
+void reference_capture(uint8_t, const column);
+void reference_overlay(uint8_t);
+void reference_poll(void);
+
+#endif
@@ -2,17 +2,133 @@
 #include "scope.h"
 #include "display.h"
 #include "bufdisplay.h"
+#include "mask.h"
+#include "trigger.h"
+#include "gate.h"
+#include "reference.h"
+#include "text.h"
+#include "timebase.h"
+#include "waterfall.h"
 #include "print_funcs.h"
 
 static uint16_t samples[SCOPE_CACHE_SIZE];
+static uint16_t math[SCOPE_CACHE_SIZE]; // selected trace, A or derived
 static volatile uint32_t sp = 0;
 static int16_t zoom = 1;
+static volatile int16_t next_zoom = 1;
+static int16_t tb_zoom = 1; // zoom left after retuning the sample clock
+
+static scope_trace trace_sel = SCOPE_TRACE_A;
+static uint16_t last_sample = 0;
+
+/*
+ * Vertical scale
+ *
+ * Samples are magnified by gain about centre before being mapped to rows,
+ * so gain 1 about mid-scale shows the full ADC range.
+ */
+static uint8_t gain = 1;
+static uint16_t centre = (SCOPE_SAMPLE_MAX + 1) / 2;
+static volatile uint8_t next_gain = 1;
+static volatile uint16_t next_centre = (SCOPE_SAMPLE_MAX + 1) / 2;
+
+static scope_display_mode mode = SCOPE_MODE_YT;
+static volatile scope_display_mode next_mode = SCOPE_MODE_YT;
+static volatile uint32_t ticks = 0;
+static volatile uint32_t trig_tick = 0;     // tick of the last trigger, 0 for none
+static volatile uint32_t trig_interval = 0; // samples between the last two
+
+/*
+ * Segmented capture
+ *
+ * The cache is split into seg_count + 1 slots of seg_len samples, the
+ * spare one holding the capture in progress so it never overwrites a
+ * segment that can be viewed. The current slot is written as a small ring
+ * until a trigger arrives with enough pre-trigger history, then filled to
+ * the end and closed with a timestamp before acquisition moves on to the
+ * next slot.
+ */
+typedef struct {
+    uint32_t end;   // write position after the last sample
+    uint32_t time;  // sample tick of the trigger
+} segment;
+
+static segment segments[SCOPE_MAX_SEGMENTS + 1];
+static uint8_t seg_count = SCOPE_MAX_SEGMENTS;
+static volatile uint8_t next_seg_count = SCOPE_MAX_SEGMENTS;
+static uint32_t seg_len = SCOPE_CACHE_SIZE / (SCOPE_MAX_SEGMENTS + 1);
+static uint8_t seg_cur = 0;
+static volatile uint8_t seg_filled = 0;
+static uint32_t seg_pos = 0;
+static uint32_t seg_pre = 0;  // pre-trigger samples held in the current segment
+static uint32_t seg_post = 0; // samples still to capture after the trigger
+static int8_t seg_view = SCOPE_SEGMENT_OVERLAY;
+
+/*
+ * Frame snapshots
+ *
+ * Display points are decimated into the back snapshot as they are
+ * acquired. Once it holds a whole frame (centred on the trigger, if one
+ * arrived) it is swapped with the front at the next frame boundary, so
+ * the renderer reads frozen points in order rather than chasing the ISR
+ * around the sample ring.
+ */
+#define SCOPE_SNAPSHOT_SIZE (128 + 8) // display points plus interpolation taps
+
+typedef struct {
+    uint16_t s[SCOPE_SNAPSHOT_SIZE];
+    uint16_t head;  // next write position
+    uint16_t count; // points held, up to SCOPE_SNAPSHOT_SIZE
+    int16_t  zoom;  // zoom the points were captured at
+} snapshot;
+
+static snapshot snap_1;
+static snapshot snap_2;
+static snapshot* front = &snap_1;
+static snapshot* back = &snap_2;
+static volatile bool back_ready = false;
+
+static uint32_t snap_step = 1;  // samples per point
+static uint32_t snap_phase = 1; // samples until the next point
+static uint16_t snap_need = 128; // points the renderer reads
+static uint16_t snap_span = 128; // points across the screen, without taps
+static uint16_t snap_post = 0;  // points still to capture after the trigger
+static uint32_t snap_wait = 0;  // samples waited for a trigger
+static uint32_t snap_timeout = 0;
+static bool snap_triggered = false;
+
+/*
+ * Amplitude histogram
+ *
+ * Every sample lands in one of 64 buckets, one per display row, including
+ * the ones the snapshot decimates away. Counts decay by 1 / 2^hist_decay
+ * each frame, or accumulate until reset when hist_decay is 0.
+ */
+static uint32_t histogram[64];
+static uint8_t hist_len[64]; // bar lengths for the current frame
+static uint8_t hist_decay = SCOPE_HISTOGRAM_DECAY;
+static volatile bool hist_reset = false;
+
+/*
+ * Plotted values
+ *
+ * Values pushed over I2C, drawn as a strip chart with the newest in
+ * column 0. Filled from the main loop, read by the draw tick.
+ */
+static int16_t plot[128];
+static volatile uint8_t plot_head = 0;
+static volatile uint8_t plot_count = 0;
+
+static volatile uint8_t persistence = SCOPE_PERSISTENCE;
+static uint8_t persistence_set = SCOPE_PERSISTENCE;
+
+static void snapshot_restart(void);
 
 void scope_zoom(int16_t z) {
     if (z == 0) z = 1;
     if (z > SCOPE_MAX_ZOOM) z = SCOPE_MAX_ZOOM;
     if (z < 0 - SCOPE_MIN_ZOOM) z = 0 - SCOPE_MIN_ZOOM;
-    zoom = z;
+    next_zoom = z;
 }
 
 static inline void increment_sp(void) {
@@ -25,39 +141,550 @@ static inline uint32_t normalize_sp(int32_t d) {
     return d % SCOPE_CACHE_SIZE;
 }
 
-static inline uint16_t get_sample(uint32_t s) {
-    return samples[normalize_sp(s)];
+static inline uint8_t sample_row(uint16_t s) {
+    int32_t v = ((int32_t)s - centre) * gain + (SCOPE_SAMPLE_MAX + 1) / 2;
+    if (v < 0)
+        v = 0;
+    if (v > SCOPE_SAMPLE_MAX)
+        v = SCOPE_SAMPLE_MAX;
+    return 63 - v / 64;
 }
 
+#ifdef SCOPE_SINC_INTERP
+/*
+ * Lanczos (a = 4) interpolation kernel in Q14, one row per 1/32 sample phase
+ * Tap j weights the sample (j - 3) steps older than the integer position
+ */
+#define SCOPE_INTERP_TAPS 8
+static const int16_t sinc_kernel[SCOPE_MAX_ZOOM][SCOPE_INTERP_TAPS] = {
+    {     0,     0,     0, 16384,     0,     0,     0,     0 },
+    {   -49,   158,  -443, 16356,   478,  -168,    53,    -1 },
+    {   -93,   304,  -850, 16271,   990,  -345,   111,    -4 },
+    {  -132,   438, -1220, 16130,  1533,  -529,   173,    -9 },
+    {  -165,   560, -1551, 15933,  2105,  -719,   238,   -17 },
+    {  -193,   668, -1845, 15685,  2703,  -913,   305,   -26 },
+    {  -216,   762, -2100, 15385,  3326, -1110,   374,   -37 },
+    {  -234,   842, -2316, 15034,  3970, -1307,   445,   -50 },
+    {  -247,   908, -2495, 14638,  4631, -1502,   516,   -65 },
+    {  -255,   961, -2638, 14196,  5308, -1693,   586,   -81 },
+    {  -258,  1000, -2744, 13711,  5995, -1877,   655,   -98 },
+    {  -258,  1025, -2816, 13193,  6689, -2053,   721,  -117 },
+    {  -253,  1039, -2856, 12635,  7388, -2218,   784,  -135 },
+    {  -246,  1040, -2864, 12050,  8086, -2370,   842,  -154 },
+    {  -235,  1030, -2842, 11435,  8780, -2506,   894,  -172 },
+    {  -222,  1009, -2794, 10797,  9466, -2623,   941,  -190 },
+    {  -207,   979, -2720, 10140, 10140, -2720,   979,  -207 },
+    {  -190,   941, -2623,  9465, 10798, -2794,  1009,  -222 },
+    {  -172,   894, -2506,  8779, 11436, -2842,  1030,  -235 },
+    {  -154,   842, -2370,  8086, 12050, -2864,  1040,  -246 },
+    {  -135,   784, -2218,  7386, 12637, -2856,  1039,  -253 },
+    {  -117,   721, -2053,  6689, 13193, -2816,  1025,  -258 },
+    {   -98,   655, -1877,  5993, 13713, -2744,  1000,  -258 },
+    {   -81,   586, -1693,  5308, 14196, -2638,   961,  -255 },
+    {   -65,   516, -1502,  4632, 14637, -2495,   908,  -247 },
+    {   -50,   445, -1307,  3970, 15034, -2316,   842,  -234 },
+    {   -37,   374, -1110,  3327, 15384, -2100,   762,  -216 },
+    {   -26,   305,  -913,  2703, 15685, -1845,   668,  -193 },
+    {   -17,   238,  -719,  2104, 15934, -1551,   560,  -165 },
+    {    -9,   173,  -529,  1533, 16130, -1220,   438,  -132 },
+    {    -4,   111,  -345,   990, 16271,  -850,   304,   -93 },
+    {    -1,    53,  -168,   478, 16356,  -443,   158,   -49 },
+};
+#endif
+
 void scope_init(void) {
     d_start_command();
     d_remap(D_REMAP_COM | D_REMAP_SPLIT | D_REMAP_VERTICAL);
     d_end();
+
+    display_persistence(persistence_set);
+    snapshot_restart();
+}
+
+void scope_mode(scope_display_mode m) {
+    next_mode = m;
+}
+
+scope_display_mode scope_get_mode(void) {
+    return mode;
+}
+
+int16_t scope_get_zoom(void) {
+    return zoom;
+}
+
+// Takes effect at the next frame
+void scope_vertical(uint8_t g, uint16_t c) {
+    if (g < 1)
+        g = 1;
+    next_gain = g;
+    next_centre = c;
+}
+
+uint8_t scope_get_gain(void) {
+    return gain;
+}
+
+uint16_t scope_get_centre(void) {
+    return centre;
+}
+
+// Samples acquired since power on
+uint32_t scope_ticks(void) {
+    return ticks;
+}
+
+// Samples between the last two triggers, or 0 if triggering has stopped
+uint32_t scope_trigger_interval(void) {
+    uint32_t interval = trig_interval;
+    if (interval == 0 || ticks - trig_tick > 2 * interval)
+        return 0;
+    return interval;
+}
+
+// Nominal samples, at SAMPLE_RATE, across the screen at a zoom
+uint32_t scope_zoom_span(int16_t z) {
+    if (z > 1)
+        return (128 * DISPLAY_DIVISOR) / z;
+    return 128 * DISPLAY_DIVISOR * (z < 0 ? -z : 1);
+}
+
+// Takes effect at the next frame, and discards any captured segments
+void scope_segments(uint8_t n) {
+    if (n < 1)
+        n = 1;
+    if (n > SCOPE_MAX_SEGMENTS)
+        n = SCOPE_MAX_SEGMENTS;
+    next_seg_count = n;
+}
+
+// 0 is the most recent segment, SCOPE_SEGMENT_OVERLAY shows them all
+void scope_segment_view(int8_t i) {
+    if (i < 0)
+        i = SCOPE_SEGMENT_OVERLAY;
+    seg_view = i;
+}
+
+// The segment being shown, after clamping to those captured
+int8_t scope_get_segment_view(void) {
+    if (seg_view == SCOPE_SEGMENT_OVERLAY || seg_filled == 0)
+        return seg_view;
+    return seg_view < seg_filled ? seg_view : seg_filled - 1;
+}
+
+uint8_t scope_segments_captured(void) {
+    return seg_filled;
+}
+
+// Slot of completed segment i, counting back from the most recent
+static inline uint8_t segment_slot(uint8_t i) {
+    return (seg_cur + seg_count - i) % (seg_count + 1);
+}
+
+// Trigger tick of segment i, counting back from the most recent, or 0 if
+// it hasn't been captured. Segments are discarded when the sample rate
+// changes, so the ticks of those held are all at timebase_rate().
+uint32_t scope_segment_time(uint8_t i) {
+    if (i >= seg_filled)
+        return 0;
+    return segments[segment_slot(i)].time;
+}
+
+static void reset_segments(void) {
+    seg_count = next_seg_count;
+    seg_len = SCOPE_CACHE_SIZE / (seg_count + 1);
+    seg_cur = 0;
+    seg_filled = 0;
+    seg_pos = 0;
+    seg_pre = 0;
+    seg_post = 0;
+}
+
+static inline void process_segment(uint16_t sample, bool triggered) {
+    samples[seg_cur * seg_len + seg_pos] = sample;
+    seg_pos = (seg_pos + 1) % seg_len;
+
+    if (seg_post) {
+        if (--seg_post == 0) {
+            segments[seg_cur].end = seg_pos;
+            seg_cur = (seg_cur + 1) % (seg_count + 1);
+            if (seg_filled < seg_count)
+                seg_filled++;
+            seg_pos = 0;
+            seg_pre = 0;
+        }
+    }
+    else if (seg_pre < seg_len / SCOPE_SEGMENT_PRETRIGGER) {
+        seg_pre++;
+    }
+    else if (triggered) {
+        segments[seg_cur].time = ticks;
+        seg_post = seg_len - seg_len / SCOPE_SEGMENT_PRETRIGGER;
+    }
+}
+
+static void snapshot_restart(void) {
+    if (tb_zoom > 1) {
+        snap_step = 1;
+        snap_span = (128 * DISPLAY_DIVISOR) / tb_zoom;
+        snap_need = snap_span + 8;
+    }
+    else {
+        snap_step = DISPLAY_DIVISOR * (tb_zoom < 0 ? -tb_zoom : 1);
+        snap_span = 128;
+        snap_need = 128;
+    }
+    snap_phase = snap_step;
+    snap_timeout = snap_need * snap_step;
+    if (snap_timeout < timebase_rate() * SCOPE_AUTO_TIMEOUT_MS / 1000)
+        snap_timeout = timebase_rate() * SCOPE_AUTO_TIMEOUT_MS / 1000;
+    snap_post = 0;
+    snap_wait = 0;
+    snap_triggered = false;
+
+    back->head = 0;
+    back->count = 0;
+    back->zoom = tb_zoom;
+    back_ready = false;
+}
+
+static inline void capture_point(uint16_t sample, bool triggered) {
+    if (back_ready)
+        return;
+
+    // only accept a trigger once the pre-trigger half is in place, and
+    // centre it on the screen rather than on the interpolation taps
+    if (triggered && !snap_triggered &&
+            back->count >= snap_need - snap_span / 2) {
+        snap_triggered = true;
+        snap_post = snap_span > 1 ? snap_span / 2 : 1;
+    }
+
+    if (!snap_triggered && back->count >= snap_need) {
+        // free run, or give up waiting for a trigger
+        if (trigger_get_edge() == TRIGGER_OFF || ++snap_wait >= snap_timeout) {
+            back_ready = true;
+            return;
+        }
+    }
+
+    if (--snap_phase)
+        return;
+    snap_phase = snap_step;
+
+    back->s[back->head] = sample;
+    back->head = (back->head + 1) % SCOPE_SNAPSHOT_SIZE;
+    if (back->count < SCOPE_SNAPSHOT_SIZE)
+        back->count++;
+
+    if (snap_triggered && --snap_post == 0)
+        back_ready = true;
+}
+
+void scope_trace_select(scope_trace t) {
+    trace_sel = t;
+}
+
+static inline uint16_t saturate(int32_t v) {
+    if (v < 0)
+        return 0;
+    if (v > SCOPE_SAMPLE_MAX)
+        return SCOPE_SAMPLE_MAX;
+    return v;
+}
+
+// Derived trace for one sample pair; signed results are centred on
+// SCOPE_MATH_ZERO
+static inline uint16_t process_math(uint16_t a, uint16_t b) {
+    switch (trace_sel) {
+        case SCOPE_TRACE_B:
+            return b;
+        case SCOPE_TRACE_A_MINUS_B:
+            return saturate((int32_t)a - b + SCOPE_MATH_ZERO);
+        case SCOPE_TRACE_A_PLUS_B:
+            return saturate((int32_t)a + b);
+        case SCOPE_TRACE_A_TIMES_B:
+            return ((uint32_t)a * b) / (SCOPE_SAMPLE_MAX + 1);
+        case SCOPE_TRACE_DERIVATIVE:
+            return saturate(((int32_t)a - last_sample) * SCOPE_DERIVATIVE_GAIN +
+                            SCOPE_MATH_ZERO);
+        default:
+            return a;
+    }
+}
+
+void scope_histogram_decay(uint8_t shift) {
+    hist_decay = shift;
+}
+
+void scope_histogram_reset(void) {
+    hist_reset = true;
+}
+
+// Copy the latest n points of the selected trace, oldest first, at the
+// current display decimation. Safe outside the ISR as long as n points
+// span less than the cache.
+void scope_window(uint16_t* buf, uint16_t n) {
+    uint32_t end = sp;
+    uint32_t step = snap_step;
+    for (uint16_t i = 0; i < n; i++)
+        buf[i] = math[normalize_sp(end - (n - 1 - i) * step)];
+}
+
+// Copy the latest n raw channel A samples and the same n samples of the
+// selected trace, oldest first. Not meaningful in segments mode, where
+// the cache holds segments rather than a ring.
+void scope_history(uint16_t* a, uint16_t* trace, uint16_t n) {
+    uint32_t end = sp;
+    for (uint16_t i = 0; i < n; i++) {
+        uint32_t s = normalize_sp(end - (n - 1 - i));
+        a[i] = samples[s];
+        trace[i] = math[s];
+    }
 }
 
-void scope_process_sample(uint16_t sample) {
+// Takes effect at the next frame
+void scope_persistence(uint8_t frames) {
+    persistence = frames;
+}
+
+void scope_plot(int16_t v) {
+    plot[plot_head] = v;
+    plot_head = (plot_head + 1) % 128;
+    if (plot_count < 128)
+        plot_count++;
+}
+
+void scope_plot_clear(void) {
+    plot_count = 0;
+}
+
+void scope_process_sample(uint16_t sample, uint16_t sample_b) {
+    bool triggered = trigger_process(sample);
+    uint16_t trace = sample;
+    ticks++;
+
+    if (triggered) {
+        if (trig_tick)
+            trig_interval = ticks - trig_tick;
+        trig_tick = ticks;
+    }
+
+    gate_process(sample, triggered);
+
+    if (trace_sel != SCOPE_TRACE_A)
+        trace = process_math(sample, sample_b);
+    last_sample = sample;
+
+    if (mode == SCOPE_MODE_SEGMENTS) {
+        process_segment(trace, triggered);
+        return;
+    }
+
     increment_sp();
     samples[sp] = sample;
+    math[sp] = trace;
+
+    if (mode == SCOPE_MODE_HISTOGRAM) {
+        histogram[sample_row(trace)]++;
+        return;
+    }
+
+    if (mode == SCOPE_MODE_WATERFALL || mode == SCOPE_MODE_PLOT)
+        return;
+
+    if (mode == SCOPE_MODE_XY) {
+        // A vertical against B horizontal, straight into the shadow
+        display_poke(sample_b * 128 / (SCOPE_SAMPLE_MAX + 1),
+                     sample_row(sample), 1);
+        return;
+    }
+
+    capture_point(trace, triggered);
+}
+
+// Point back from the newest in the snapshot
+static inline uint16_t snapshot_point(const snapshot* f, int32_t back) {
+    if (back < 0) // don't read ahead of the frame
+        back = 0;
+    if (back >= f->count)
+        back = f->count - 1;
+    return f->s[(f->head + SCOPE_SNAPSHOT_SIZE - 1 - back) % SCOPE_SNAPSHOT_SIZE];
+}
+
+// Reconstruct the signal between samples when magnified, rather than
+// repeating each sample zoom times
+static inline uint16_t get_trace_sample(const snapshot* f, uint8_t col) {
+    if (f->zoom <= 1)
+        return snapshot_point(f, col);
+
+    // distance behind the newest point in 1/zoom sample steps
+    uint32_t pos = col * DISPLAY_DIVISOR;
+    int32_t i = pos / f->zoom;
+    uint8_t phase = (pos % f->zoom) * SCOPE_MAX_ZOOM / f->zoom;
+
+#ifdef SCOPE_SINC_INTERP
+    const int16_t* k = sinc_kernel[phase];
+    int32_t acc = 0;
+    for (uint8_t j = 0; j < SCOPE_INTERP_TAPS; j++)
+        acc += k[j] * snapshot_point(f, i + j - 3);
+    acc = (acc + (1 << 13)) >> 14;
+    if (acc < 0)
+        acc = 0;
+    if (acc > SCOPE_SAMPLE_MAX)
+        acc = SCOPE_SAMPLE_MAX;
+    return acc;
+#else
+    int32_t s0 = snapshot_point(f, i);
+    int32_t s1 = snapshot_point(f, i + 1);
+    return s0 + ((s1 - s0) * phase) / SCOPE_MAX_ZOOM;
+#endif
 }
 
-static inline int32_t get_offset(uint32_t base, int32_t offset) {
-    if (zoom > 0)
-        return (int32_t)base + ((offset * DISPLAY_DIVISOR) / zoom);
-    return (int32_t)base + ((offset * DISPLAY_DIVISOR) * zoom);
+// Segment samples from newest (col 0) to oldest, scaled to the screen
+static inline uint16_t get_segment_sample(uint8_t seg, uint8_t col) {
+    uint32_t back = 1 + (col * seg_len) / 128;
+    uint32_t i = (segments[seg].end + seg_len - back) % seg_len;
+    return samples[seg * seg_len + i];
+}
+
+static inline void segment_column(uint8_t col, column trace) {
+    if (seg_filled == 0)
+        return;
+
+    if (seg_view == SCOPE_SEGMENT_OVERLAY) {
+        for (uint8_t i = 0; i < seg_filled; i++) {
+            column_set(trace, sample_row(get_segment_sample(segment_slot(i), col)));
+        }
+        return;
+    }
+
+    uint8_t i = seg_view < seg_filled ? seg_view : seg_filled - 1;
+    column_set(trace, sample_row(get_segment_sample(segment_slot(i), col)));
+}
+
+static void histogram_frame(void) {
+    uint32_t max = 0;
+    for (uint8_t r = 0; r < 64; r++) {
+        if (hist_reset)
+            histogram[r] = 0;
+        if (histogram[r] > max)
+            max = histogram[r];
+    }
+    hist_reset = false;
+
+    uint32_t scale = max / 128 + 1;
+    for (uint8_t r = 0; r < 64; r++) {
+        hist_len[r] = histogram[r] / scale;
+        if (hist_decay)
+            histogram[r] -= histogram[r] >> hist_decay;
+    }
+}
+
+// Horizontal bars, one per row
+static inline void histogram_column(uint8_t col, column trace) {
+    for (uint8_t r = 0; r < 64; r++) {
+        if (hist_len[r] > col)
+            column_set(trace, r);
+    }
+}
+
+static inline void plot_column(uint8_t col, column trace) {
+    if (col >= plot_count)
+        return;
+
+    int16_t v = plot[(plot_head + 127 - col) % 128];
+    if (v < 0)
+        v = 0;
+    if (v > SCOPE_PLOT_MAX)
+        v = SCOPE_PLOT_MAX;
+    column_set(trace, 63 - ((int32_t)v * 64) / (SCOPE_PLOT_MAX + 1));
 }
 
 void scope_draw() {
     static uint8_t count = 0;
-    static uint32_t rp = 0;
+    static bool published = false; // this frame shows a capture not yet tested
 
     if (count == 0) {
+        mask_start_frame();
+        // hold the failing frame on screen
+        if (mask_frozen())
+            return;
+        if (persistence != persistence_set) {
+            persistence_set = persistence;
+            display_persistence(persistence_set);
+        }
         display_new_frame();
-        rp = sp;
+        published = false;
+        gain = next_gain;
+        centre = next_centre;
+        text_frame();
+
+        if (next_mode != mode || next_seg_count != seg_count) {
+            // the waterfall draws behind the display buffer's back
+            if (mode == SCOPE_MODE_WATERFALL || next_mode == SCOPE_MODE_WATERFALL)
+                display_reset();
+            mode = next_mode;
+            display_rolling(mode == SCOPE_MODE_XY);
+            reset_segments();
+        }
+
+        if (next_zoom != zoom) {
+            uint32_t rate = timebase_rate();
+            zoom = next_zoom;
+            tb_zoom = timebase_set(zoom);
+            snapshot_restart();
+            // segment times are in ticks, which only compare at one rate
+            if (timebase_rate() != rate)
+                reset_segments();
+            // intervals at the old sample rate no longer mean anything
+            trig_tick = 0;
+            trig_interval = 0;
+        }
+        else if (back_ready) {
+            snapshot* temp = front;
+            front = back;
+            back = temp;
+            snapshot_restart();
+            published = true;
+        }
+
+        // only Y-T frames are held until a new capture replaces them
+        if (mode != SCOPE_MODE_YT)
+            published = true;
+
+        if (mode == SCOPE_MODE_HISTOGRAM)
+            histogram_frame();
     }
 
+    if (mode == SCOPE_MODE_WATERFALL) {
+        waterfall_draw(count);
+        count = (count + 1) % 128;
+        return;
+    }
+
+    // XY points land anywhere, so render whichever pairs they touched
+    if (mode == SCOPE_MODE_XY) {
+        if (count % 2 == 0)
+            display_render_dirty();
+        count = (count + 1) % 128;
+        return;
+    }
 
-    uint8_t y = 63 - get_sample(get_offset(rp, -count)) / 64;
-    display_poke(count, y, 1);
+    column trace = { 0, 0 };
+    if (mode == SCOPE_MODE_SEGMENTS)
+        segment_column(count, trace);
+    else if (mode == SCOPE_MODE_HISTOGRAM)
+        histogram_column(count, trace);
+    else if (mode == SCOPE_MODE_PLOT)
+        plot_column(count, trace);
+    else if (front->count)
+        column_set(trace, sample_row(get_trace_sample(front, count)));
+    reference_capture(count, trace);
+    reference_overlay(count);
+    text_blit(count);
+    mask_overlay(count, mask_test(count, trace));
+    display_blit(count, trace);
 
     count++;
 
@@ -66,4 +693,7 @@ void scope_draw() {
     }
 
     count %= 128;
+
+    if (count == 0)
+        mask_end_frame(published);
 }
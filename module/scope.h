@@ -3,9 +3,51 @@
 
 #include <stdint.h>
 
+#define SCOPE_SEGMENT_OVERLAY -1
+
+typedef enum {
+    SCOPE_MODE_YT,
+    SCOPE_MODE_SEGMENTS,
+    SCOPE_MODE_XY,
+    SCOPE_MODE_HISTOGRAM,
+    SCOPE_MODE_WATERFALL,
+    SCOPE_MODE_PLOT
+} scope_display_mode;
+
+typedef enum {
+    SCOPE_TRACE_A,
+    SCOPE_TRACE_B,
+    SCOPE_TRACE_A_MINUS_B,
+    SCOPE_TRACE_A_PLUS_B,
+    SCOPE_TRACE_A_TIMES_B,
+    SCOPE_TRACE_DERIVATIVE
+} scope_trace;
+
 void scope_init(void);
 void scope_draw(void);
 void scope_zoom(int16_t);
-void scope_process_sample(uint16_t);
+void scope_process_sample(uint16_t, uint16_t);
+void scope_mode(scope_display_mode);
+scope_display_mode scope_get_mode(void);
+void scope_window(uint16_t*, uint16_t);
+void scope_history(uint16_t*, uint16_t*, uint16_t);
+int16_t scope_get_zoom(void);
+void scope_vertical(uint8_t, uint16_t);
+uint8_t scope_get_gain(void);
+uint16_t scope_get_centre(void);
+uint32_t scope_ticks(void);
+uint32_t scope_trigger_interval(void);
+uint32_t scope_zoom_span(int16_t);
+void scope_trace_select(scope_trace);
+void scope_histogram_decay(uint8_t);
+void scope_histogram_reset(void);
+void scope_persistence(uint8_t);
+void scope_plot(int16_t);
+void scope_plot_clear(void);
+void scope_segments(uint8_t);
+void scope_segment_view(int8_t);
+int8_t scope_get_segment_view(void);
+uint8_t scope_segments_captured(void);
+uint32_t scope_segment_time(uint8_t);
 
 #endif
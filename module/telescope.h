@@ -5,3 +5,22 @@
 #define SCOPE_MIN_ZOOM 32 
 #define SCOPE_CACHE_SIZE (128 * DISPLAY_DIVISOR * SCOPE_MIN_ZOOM)
 //#define TWO_TIMERS // Async display update (doesn't work well)
+#define SCOPE_SAMPLE_MAX 4095 // 12-bit ADC
+//#define SCOPE_SINC_INTERP // Windowed-sinc zoom interpolation (default linear)
+#define SCOPE_PERSISTENCE DISPLAY_PERSIST_OFF // frames, or DISPLAY_PERSIST_INFINITE
+#define SCOPE_MAX_SEGMENTS 32
+#define SCOPE_SEGMENT_PRETRIGGER 4 // 1/4 of each segment precedes the trigger
+#define SCOPE_AUTO_TIMEOUT_MS 100 // free run after this long without a trigger
+#define SCOPE_CHANNEL_A 0 // adc[] index of the main input
+#define SCOPE_CHANNEL_B 2 // adc[] index of the XY horizontal / math input
+#define SCOPE_MATH_ZERO 2048 // zero level of signed math traces
+#define SCOPE_DERIVATIVE_GAIN 16
+#define SCOPE_HISTOGRAM_DECAY 4 // counts lose 1/16 per frame
+#define SCOPE_PLOT_MAX 16383 // full scale of plotted teletype values
+#define GATE_CHANNEL 0    // DAC output for the gate / trigger
+#define GATE_SH_CHANNEL 1 // DAC output for sample and hold
+#define GATE_HIGH 2048    // gate level, half scale
+#define GATE_TRIGGER_MS 10
+#define SCOPE_FULL_SCALE_MV 10000 // input span across the ADC range
+#define SCOPE_DIV_ROWS 8     // rows per vertical division
+#define SCOPE_DIV_COLS 16    // columns per horizontal division
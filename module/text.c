@@ -0,0 +1,114 @@
+/*
+ * text.c
+ *
+ * Text layer in the display's column format
+ *
+ * Every glyph is rendered once at init and transposed into one byte per
+ * pixel column, so printing is a shift and an OR per column. Text is laid
+ * out in a back layer from the main loop and swapped in at a frame
+ * boundary; the draw tick overlays the front layer a column at a time,
+ * outside persistence, and the diff renderer only sends the columns whose
+ * text changed.
+ *                                                                          */
+
+#include "text.h"
+#include "bufdisplay.h"
+
+#include "font.h"
+
+#include <string.h> // memset()
+
+#define TEXT_GLYPHS (TEXT_LAST - TEXT_FIRST + 1)
+
+typedef struct {
+    uint8_t col[FONT_CHARW]; // bit r set for row r, top down
+    uint8_t width;
+} glyph;
+
+static glyph glyphs[TEXT_GLYPHS];
+
+static column  layer_1[128];
+static column  layer_2[128];
+static column* front = layer_1;
+static column* back = layer_2;
+static volatile bool back_ready = false;
+
+void text_init(void) {
+    u8 scratch[FONT_CHARH * FONT_CHARW];
+
+    for (uint8_t i = 0; i < TEXT_GLYPHS; i++) {
+        memset(scratch, 0, sizeof(scratch));
+        u8* end = font_glyph(TEXT_FIRST + i, scratch, FONT_CHARW, 1, 0);
+        glyph* g = &glyphs[i];
+
+        g->width = end - scratch;
+        if (g->width == 0 || g->width > FONT_CHARW) // blank glyphs
+            g->width = FONT_CHARW / 2;
+
+        for (uint8_t c = 0; c < FONT_CHARW; c++) {
+            g->col[c] = 0;
+            for (uint8_t r = 0; r < FONT_CHARH; r++) {
+                if (scratch[r * FONT_CHARW + c])
+                    g->col[c] |= 1 << r;
+            }
+        }
+    }
+
+    memset(layer_1, 0, sizeof(layer_1));
+    memset(layer_2, 0, sizeof(layer_2));
+}
+
+// Start laying out a new layer, false while the last is still pending
+bool text_begin(void) {
+    if (back_ready)
+        return false;
+    memset(back, 0, sizeof(layer_1));
+    return true;
+}
+
+// Print at a pixel position, returning the column after the text
+uint8_t text_print(uint8_t col, uint8_t row, const char* s) {
+    if (row > 64 - FONT_CHARH)
+        return col;
+
+    for (; *s; s++) {
+        char ch = *s;
+        if (ch < TEXT_FIRST || ch > TEXT_LAST)
+            ch = '?';
+        const glyph* g = &glyphs[ch - TEXT_FIRST];
+
+        for (uint8_t c = 0; c < g->width; c++, col++) {
+            if (col > 127)
+                return 128;
+            uint32_t m = g->col[c];
+            if (row < 32) {
+                back[col][0] |= m << row;
+                if (row > 32 - FONT_CHARH)
+                    back[col][1] |= m >> (32 - row);
+            }
+            else
+                back[col][1] |= m << (row - 32);
+        }
+        col += TEXT_SPACING;
+    }
+    return col < 128 ? col : 128;
+}
+
+// Hand the layer to the draw tick
+void text_commit(void) {
+    back_ready = true;
+}
+
+// Called at the start of each frame
+void text_frame(void) {
+    if (!back_ready)
+        return;
+    column* temp = front;
+    front = back;
+    back = temp;
+    back_ready = false;
+}
+
+void text_blit(uint8_t col) {
+    display_overlay(col, front[col]);
+}
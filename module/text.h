@@ -0,0 +1,18 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TEXT_FIRST ' '
+#define TEXT_LAST '~'
+#define TEXT_SPACING 1 // blank columns between glyphs
+
+void text_init(void);
+bool text_begin(void);
+uint8_t text_print(uint8_t, uint8_t, const char*);
+void text_commit(void);
+void text_frame(void);
+void text_blit(uint8_t);
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * timebase.c
+ *
+ * Sample clock control
+ *
+ * Rather than always sampling at SAMPLE_RATE and decimating or repeating
+ * samples, the sample timer is retuned so that slow timebases take fewer
+ * samples and fast ones take more. Whatever the timer can't cover is left
+ * to the scope as a residual zoom.
+ *                                                                          */
+
+#include "conf_board.h"
+#include "conf_tc_irq.h"
+#include "tc.h"
+
+#include "telescope.h"
+#include "timebase.h"
+
+static uint16_t rc = TIMEBASE_RC;
+static uint16_t divisor = DISPLAY_DIVISOR;
+
+// Retune the sample clock for a zoom, returning the zoom left over
+int16_t timebase_set(int16_t zoom) {
+    uint16_t z = zoom < 0 ? -zoom : zoom;
+    uint16_t limit = zoom < 0 ? TIMEBASE_MAX_SLOW : TIMEBASE_MAX_FAST;
+    uint16_t m = 1;
+
+    // largest power of two the timer can absorb exactly
+    while (m * 2 <= limit && z % (m * 2) == 0)
+        m *= 2;
+
+    uint16_t new_rc;
+    if (zoom < 0) {
+        new_rc = TIMEBASE_RC * m;
+        divisor = DISPLAY_DIVISOR / m;
+        if (divisor == 0)
+            divisor = 1;
+    }
+    else {
+        new_rc = TIMEBASE_RC / m;
+        divisor = DISPLAY_DIVISOR * m;
+    }
+
+    if (new_rc != rc) {
+        rc = new_rc;
+        tc_write_rc(APP_TC, 0, rc);
+        // restart the count in case it is already past the new RC
+        tc_software_trigger(APP_TC, 0);
+    }
+
+    z /= m;
+    if (z <= 1)
+        return 1;
+    return zoom < 0 ? -(int16_t)z : (int16_t)z;
+}
+
+// Samples per scope_draw() call. Columns stay near DISPLAY_RATE as the
+// clock speeds up, but a slowed clock can't draw more than one column per
+// sample, so there the column rate falls with the sample rate.
+uint16_t timebase_divisor(void) {
+    return divisor;
+}
+
+// Sample rate in Hz
+uint32_t timebase_rate(void) {
+    return TIMEBASE_CLOCK_HZ / rc;
+}
@@ -0,0 +1,15 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+#define TIMEBASE_CLOCK_HZ (FPBA_HZ / 2) // TC_CLOCK_SOURCE_TC2
+#define TIMEBASE_RC (TIMEBASE_CLOCK_HZ / SAMPLE_RATE) // sample timer period at zoom 1
+#define TIMEBASE_MAX_SLOW 8  // longest period that fits the 16-bit RC
+#define TIMEBASE_MAX_FAST 4  // shortest period the ISR keeps up with
+
+int16_t timebase_set(int16_t);
+uint16_t timebase_divisor(void);
+uint32_t timebase_rate(void);
+
+#endif
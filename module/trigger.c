@@ -0,0 +1,57 @@
+/*
+ * trigger.c
+ *
+ * Edge trigger with hysteresis
+ *
+ * The trigger arms once the signal has been on the far side of the level
+ * by at least TRIGGER_HYSTERESIS, and fires on the next crossing.
+ *                                                                          */
+
+#include "trigger.h"
+
+static trigger_edge edge = TRIGGER_RISING;
+static uint16_t level = 2048;
+static bool armed = false;
+
+void trigger_set_edge(trigger_edge e) {
+    edge = e;
+    armed = false;
+}
+
+trigger_edge trigger_get_edge(void) {
+    return edge;
+}
+
+void trigger_set_level(uint16_t l) {
+    level = l;
+    armed = false;
+}
+
+uint16_t trigger_get_level(void) {
+    return level;
+}
+
+// Returns true on the sample that crosses the trigger level
+bool trigger_process(uint16_t sample) {
+    switch (edge) {
+        case TRIGGER_RISING:
+            if (sample + TRIGGER_HYSTERESIS < level)
+                armed = true;
+            else if (armed && sample >= level) {
+                armed = false;
+                return true;
+            }
+            break;
+        case TRIGGER_FALLING:
+            if (sample > level + TRIGGER_HYSTERESIS)
+                armed = true;
+            else if (armed && sample <= level) {
+                armed = false;
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    return false;
+}
@@ -0,0 +1,21 @@
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRIGGER_HYSTERESIS 64 // one display row
+
+typedef enum {
+    TRIGGER_OFF,
+    TRIGGER_RISING,
+    TRIGGER_FALLING
+} trigger_edge;
+
+void trigger_set_edge(trigger_edge);
+trigger_edge trigger_get_edge(void);
+void trigger_set_level(uint16_t);
+uint16_t trigger_get_level(void);
+bool trigger_process(uint16_t);
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * waterfall.c
+ *
+ * Spectrogram / waterfall display
+ *
+ * The main loop turns the latest window of the trace into a 64 bin
+ * spectrum line, one greyscale nibble per pixel. The draw tick shifts the
+ * screen up a row with the SSD1325 copy accelerator and sends just the new
+ * line, 64 data bytes, into the bottom row.
+ *                                                                          */
+
+#include "waterfall.h"
+#include "display.h"
+#include "scope.h"
+
+#include <stdbool.h>
+
+// sin(2 pi k / 128) in Q15, three quarters of a period so cos is k + 32
+static const int16_t sin_table[96] = {
+         0,   1608,   3212,   4808,   6393,   7962,   9512,  11039,
+     12539,  14010,  15446,  16846,  18204,  19519,  20787,  22005,
+     23170,  24279,  25329,  26319,  27245,  28105,  28898,  29621,
+     30273,  30852,  31356,  31785,  32137,  32412,  32609,  32728,
+     32767,  32728,  32609,  32412,  32137,  31785,  31356,  30852,
+     30273,  29621,  28898,  28105,  27245,  26319,  25329,  24279,
+     23170,  22005,  20787,  19519,  18204,  16846,  15446,  14010,
+     12539,  11039,   9512,   7962,   6393,   4808,   3212,   1608,
+         0,  -1608,  -3212,  -4808,  -6393,  -7962,  -9512, -11039,
+    -12539, -14010, -15446, -16846, -18204, -19519, -20787, -22005,
+    -23170, -24279, -25329, -26319, -27245, -28105, -28898, -29621,
+    -30273, -30852, -31356, -31785, -32137, -32412, -32609, -32728,
+};
+
+// first half of a 128 point Hann window in Q15
+static const int16_t hann[64] = {
+         0,     20,     80,    180,    320,    499,    717,    973,
+      1267,   1597,   1965,   2367,   2803,   3273,   3775,   4308,
+      4870,   5461,   6078,   6721,   7387,   8075,   8784,   9511,
+     10254,  11013,  11785,  12569,  13361,  14161,  14967,  15776,
+     16586,  17396,  18203,  19006,  19803,  20591,  21369,  22135,
+     22886,  23622,  24340,  25039,  25716,  26371,  27001,  27605,
+     28181,  28729,  29247,  29733,  30186,  30606,  30990,  31340,
+     31652,  31927,  32164,  32363,  32522,  32642,  32722,  32762,
+};
+
+static int16_t re[WATERFALL_N];
+static int16_t im[WATERFALL_N];
+static uint16_t window[WATERFALL_N];
+
+// d_burst() stream: row window, then one byte per pixel pair
+#define LINE_PIXELS 8
+static uint8_t line[1 + 6 + 1 + WATERFALL_N / 2] = {
+    D_BURST_COMMAND | 6,
+    D_SET_COL, 0, 63,
+    D_SET_ROW, 63, 63,
+    D_BURST_DATA | (WATERFALL_N / 2)
+};
+
+static volatile bool line_ready = false;
+static volatile bool line_copied = false;
+
+// In place radix-2 FFT, halving at each stage to stay in range
+static void fft(void) {
+    for (uint16_t i = 1, j = 0; i < WATERFALL_N; i++) {
+        uint16_t bit = WATERFALL_N >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            int16_t t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+
+    for (uint16_t len = 2; len <= WATERFALL_N; len <<= 1) {
+        uint16_t step = WATERFALL_N / len;
+        for (uint16_t i = 0; i < WATERFALL_N; i += len) {
+            for (uint16_t k = 0; k < len / 2; k++) {
+                int32_t wr = sin_table[k * step + 32];
+                int32_t wi = -sin_table[k * step];
+                uint16_t a = i + k;
+                uint16_t b = a + len / 2;
+                int32_t tr = (re[b] * wr - im[b] * wi) >> 15;
+                int32_t ti = (re[b] * wi + im[b] * wr) >> 15;
+                re[b] = (re[a] - tr) >> 1;
+                im[b] = (im[a] - ti) >> 1;
+                re[a] = (re[a] + tr) >> 1;
+                im[a] = (im[a] + ti) >> 1;
+            }
+        }
+    }
+}
+
+// Roughly logarithmic: one grey level per doubling of magnitude
+static inline uint8_t grey(int32_t r, int32_t i) {
+    if (r < 0)
+        r = -r;
+    if (i < 0)
+        i = -i;
+    uint32_t mag = r > i ? r + i / 2 : i + r / 2;
+    if (mag == 0)
+        return 0;
+    uint8_t g = 32 - __builtin_clz(mag);
+    return g > 15 ? 15 : g;
+}
+
+// Build the next line whenever the draw tick has taken the last one
+void waterfall_poll(void) {
+    if (line_ready || scope_get_mode() != SCOPE_MODE_WATERFALL)
+        return;
+
+    scope_window(window, WATERFALL_N);
+
+    int32_t mean = 0;
+    for (uint16_t i = 0; i < WATERFALL_N; i++)
+        mean += window[i];
+    mean /= WATERFALL_N;
+
+    for (uint16_t i = 0; i < WATERFALL_N; i++) {
+        int32_t w = hann[i < 64 ? i : WATERFALL_N - 1 - i];
+        re[i] = (((int32_t)window[i] - mean) * 8 * w) >> 15;
+        im[i] = 0;
+    }
+
+    fft();
+
+    for (uint8_t i = 0; i < WATERFALL_N / 2; i++) {
+        uint8_t g = grey(re[i], im[i]);
+        line[LINE_PIXELS + i] = g | (g << 4);
+    }
+
+    line_ready = true;
+}
+
+// Scroll on the first tick of a frame, send the line on the next
+void waterfall_draw(uint8_t count) {
+    if (!line_ready)
+        return;
+
+    if (count == 0) {
+        d_start_command();
+        d_copy(0, 1, 63, 63, 0, 0);
+        d_end();
+        line_copied = true;
+    }
+    else if (line_copied) {
+        d_burst(line, sizeof(line));
+        d_end();
+        line_copied = false;
+        line_ready = false;
+    }
+}
@@ -0,0 +1,11 @@
+#ifndef WATERFALL_H
+#define WATERFALL_H
+
+#include <stdint.h>
+
+#define WATERFALL_N 128 // FFT length, giving 64 bins of 2 pixels each
+
+void waterfall_poll(void);
+void waterfall_draw(uint8_t);
+
+#endif
@@ -0,0 +1,133 @@
+#include "fakes.h"
+
+#include "autoset.h"
+#include "gate.h"
+#include "i2c.h"
+#include "mask.h"
+#include "readout.h"
+#include "reference.h"
+#include "scope.h"
+#include "trigger.h"
+
+#include <string.h>
+
+fake_calls calls;
+
+volatile process_ii_t process_ii = 0;
+
+void init_i2c_slave(uint8_t addr) {
+    calls.slave_addr = addr;
+}
+
+// A message arriving from the bus, through whatever handler is registered
+void bus_send(const uint8_t* data, uint8_t len) {
+    uint8_t buf[256];
+    memcpy(buf, data, len);
+    if (process_ii)
+        process_ii(buf, len);
+}
+
+void fakes_reset(void) {
+    memset(&calls, 0, sizeof(calls));
+}
+
+void scope_zoom(int16_t z) {
+    calls.zoom_calls++;
+    calls.zoom = z;
+}
+
+void trigger_set_level(uint16_t l) {
+    calls.level_calls++;
+    calls.level = l;
+}
+
+void trigger_set_edge(trigger_edge e) {
+    (void)e;
+    calls.edge_calls++;
+}
+
+void scope_trace_select(scope_trace t) {
+    (void)t;
+    calls.trace_calls++;
+}
+
+void scope_mode(scope_display_mode m) {
+    (void)m;
+    calls.mode_calls++;
+}
+
+void scope_persistence(uint8_t f) {
+    (void)f;
+    calls.persistence_calls++;
+}
+
+void scope_segments(uint8_t n) {
+    (void)n;
+    calls.segments_calls++;
+}
+
+void scope_segment_view(int8_t i) {
+    calls.segment_view_calls++;
+    calls.segment_view = i;
+}
+
+void mask_learn(uint8_t t) {
+    (void)t;
+    calls.mask_learn_calls++;
+}
+
+void mask_clear(void) {
+    calls.mask_clear_calls++;
+}
+
+void mask_freeze_on_fail(bool f) {
+    (void)f;
+    calls.mask_freeze_calls++;
+}
+
+void mask_reset_counts(void) {
+    calls.mask_reset_calls++;
+}
+
+void scope_histogram_reset(void) {
+    calls.histogram_reset_calls++;
+}
+
+void gate_set_mode(gate_mode m) {
+    (void)m;
+    calls.gate_mode_calls++;
+}
+
+void gate_sample_hold(bool s) {
+    (void)s;
+    calls.sample_hold_calls++;
+}
+
+void reference_save(uint8_t s) {
+    (void)s;
+    calls.reference_save_calls++;
+}
+
+void reference_show(int8_t s) {
+    calls.reference_show_calls++;
+    calls.reference_show = s;
+}
+
+void scope_plot(int16_t v) {
+    if (calls.plot_calls < 64)
+        calls.plot[calls.plot_calls] = v;
+    calls.plot_calls++;
+}
+
+void scope_plot_clear(void) {
+    calls.plot_clear_calls++;
+}
+
+void autoset_start(void) {
+    calls.autoset_calls++;
+}
+
+void readout_show(bool s) {
+    (void)s;
+    calls.readout_calls++;
+}
@@ -0,0 +1,42 @@
+#ifndef FAKES_H
+#define FAKES_H
+
+#include <stdint.h>
+
+// Calls the follower made into the rest of the firmware
+typedef struct {
+    uint8_t slave_addr;
+    int zoom_calls;
+    int16_t zoom;
+    int level_calls;
+    uint16_t level;
+    int edge_calls;
+    int trace_calls;
+    int mode_calls;
+    int persistence_calls;
+    int segments_calls;
+    int segment_view_calls;
+    int8_t segment_view;
+    int mask_learn_calls;
+    int mask_clear_calls;
+    int mask_freeze_calls;
+    int mask_reset_calls;
+    int histogram_reset_calls;
+    int gate_mode_calls;
+    int sample_hold_calls;
+    int reference_save_calls;
+    int reference_show_calls;
+    int8_t reference_show;
+    int plot_calls;
+    int16_t plot[64];
+    int plot_clear_calls;
+    int autoset_calls;
+    int readout_calls;
+} fake_calls;
+
+extern fake_calls calls;
+
+void fakes_reset(void);
+void bus_send(const uint8_t*, uint8_t);
+
+#endif
@@ -0,0 +1,12 @@
+// Stand-in for libavr32's i2c.h, the bus driver is fakes.c
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+
+typedef void (*process_ii_t)(uint8_t*, uint8_t);
+
+extern volatile process_ii_t process_ii;
+void init_i2c_slave(uint8_t);
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * follower_tests.c
+ *
+ * Host tests for the I2C follower, driven through a stand-in bus driver
+ *                                                                          */
+
+#include "fakes.h"
+#include "follower.h"
+#include "gate.h"
+#include "i2c.h"
+#include "scope.h"
+#include "trigger.h"
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define CHECK(c)                                                     \
+    do {                                                             \
+        if (!(c)) {                                                  \
+            printf("  %s:%d: %s\n", __FILE__, __LINE__, #c);         \
+            failures++;                                              \
+        }                                                            \
+    } while (0)
+
+#define SEND(...)                                                    \
+    do {                                                             \
+        const uint8_t m[] = { __VA_ARGS__ };                         \
+        bus_send(m, sizeof(m));                                      \
+    } while (0)
+
+static void setup(void) {
+    follower_poll(); // drain anything a previous test left
+    fakes_reset();
+    follower_init();
+}
+
+static void test_init(void) {
+    setup();
+    CHECK(process_ii == &follower_receive);
+    CHECK(calls.slave_addr == FOLLOWER_II_ADDR);
+    // plain 7-bit addresses only
+    CHECK(FOLLOWER_II_ADDR >= 0x08 && FOLLOWER_II_ADDR <= 0x77);
+}
+
+static void test_deferred_to_poll(void) {
+    setup();
+    SEND(FOLLOWER_HISTOGRAM_RESET);
+    CHECK(calls.histogram_reset_calls == 0);
+    follower_poll();
+    CHECK(calls.histogram_reset_calls == 1);
+    follower_poll();
+    CHECK(calls.histogram_reset_calls == 1);
+}
+
+static void test_arguments(void) {
+    setup();
+    SEND(FOLLOWER_ZOOM, 0xFF, 0xF0);
+    SEND(FOLLOWER_TRIGGER_LEVEL, 0x0A, 0xBC);
+    SEND(FOLLOWER_SEGMENT_VIEW, 0xFF);
+    SEND(FOLLOWER_REFERENCE_SHOW, 0x03);
+    follower_poll();
+    CHECK(calls.zoom_calls == 1 && calls.zoom == -16);
+    CHECK(calls.level_calls == 1 && calls.level == 0x0ABC);
+    CHECK(calls.segment_view_calls == 1 && calls.segment_view == -1);
+    CHECK(calls.reference_show_calls == 1 && calls.reference_show == 3);
+}
+
+static void test_every_command(void) {
+    setup();
+    SEND(FOLLOWER_TRIGGER_EDGE, TRIGGER_FALLING);
+    SEND(FOLLOWER_TRACE, SCOPE_TRACE_DERIVATIVE);
+    SEND(FOLLOWER_MODE, SCOPE_MODE_PLOT);
+    SEND(FOLLOWER_PERSISTENCE, 4);
+    SEND(FOLLOWER_SEGMENTS, 8);
+    SEND(FOLLOWER_MASK_LEARN, 2);
+    SEND(FOLLOWER_MASK_CLEAR);
+    SEND(FOLLOWER_MASK_FREEZE, 1);
+    SEND(FOLLOWER_MASK_RESET);
+    follower_poll(); // stay inside the queue
+    SEND(FOLLOWER_GATE_MODE, GATE_TRIGGER);
+    SEND(FOLLOWER_SAMPLE_HOLD, 1);
+    SEND(FOLLOWER_REFERENCE_SAVE, 0);
+    SEND(FOLLOWER_PLOT_CLEAR);
+    SEND(FOLLOWER_AUTOSET);
+    SEND(FOLLOWER_READOUT, 0);
+    follower_poll();
+    CHECK(calls.edge_calls == 1);
+    CHECK(calls.trace_calls == 1);
+    CHECK(calls.mode_calls == 1);
+    CHECK(calls.persistence_calls == 1);
+    CHECK(calls.segments_calls == 1);
+    CHECK(calls.mask_learn_calls == 1);
+    CHECK(calls.mask_clear_calls == 1);
+    CHECK(calls.mask_freeze_calls == 1);
+    CHECK(calls.mask_reset_calls == 1);
+    CHECK(calls.gate_mode_calls == 1);
+    CHECK(calls.sample_hold_calls == 1);
+    CHECK(calls.reference_save_calls == 1);
+    CHECK(calls.plot_clear_calls == 1);
+    CHECK(calls.autoset_calls == 1);
+    CHECK(calls.readout_calls == 1);
+}
+
+static void test_short_frames(void) {
+    setup();
+    SEND(FOLLOWER_ZOOM);
+    SEND(FOLLOWER_ZOOM, 0x01);
+    SEND(FOLLOWER_TRIGGER_LEVEL, 0x08);
+    SEND(FOLLOWER_TRIGGER_EDGE);
+    SEND(FOLLOWER_TRACE);
+    SEND(FOLLOWER_MODE);
+    SEND(FOLLOWER_PERSISTENCE);
+    SEND(FOLLOWER_SEGMENTS);
+    SEND(FOLLOWER_SEGMENT_VIEW);
+    SEND(FOLLOWER_MASK_LEARN);
+    SEND(FOLLOWER_MASK_FREEZE);
+    SEND(FOLLOWER_GATE_MODE);
+    SEND(FOLLOWER_SAMPLE_HOLD);
+    SEND(FOLLOWER_REFERENCE_SAVE);
+    SEND(FOLLOWER_REFERENCE_SHOW);
+    SEND(FOLLOWER_READOUT);
+    SEND(FOLLOWER_PLOT, 0x01); // half a value
+    follower_poll();
+    CHECK(calls.zoom_calls == 0);
+    CHECK(calls.level_calls == 0);
+    CHECK(calls.edge_calls == 0);
+    CHECK(calls.trace_calls == 0);
+    CHECK(calls.mode_calls == 0);
+    CHECK(calls.persistence_calls == 0);
+    CHECK(calls.segments_calls == 0);
+    CHECK(calls.segment_view_calls == 0);
+    CHECK(calls.mask_learn_calls == 0);
+    CHECK(calls.mask_freeze_calls == 0);
+    CHECK(calls.gate_mode_calls == 0);
+    CHECK(calls.sample_hold_calls == 0);
+    CHECK(calls.reference_save_calls == 0);
+    CHECK(calls.reference_show_calls == 0);
+    CHECK(calls.readout_calls == 0);
+    CHECK(calls.plot_calls == 0);
+}
+
+static void test_malformed_frames(void) {
+    setup();
+    bus_send(NULL, 0); // empty
+    SEND(0x7F, 1, 2, 3); // unknown command
+    SEND(FOLLOWER_TRIGGER_EDGE, TRIGGER_FALLING + 1);
+    SEND(FOLLOWER_TRACE, SCOPE_TRACE_DERIVATIVE + 1);
+    SEND(FOLLOWER_MODE, SCOPE_MODE_PLOT + 1);
+    SEND(FOLLOWER_GATE_MODE, GATE_TRIGGER + 1);
+    SEND(FOLLOWER_PLOT, 0x00, 0x05, 0xFF); // trailing odd byte
+    follower_poll();
+    CHECK(calls.edge_calls == 0);
+    CHECK(calls.trace_calls == 0);
+    CHECK(calls.mode_calls == 0);
+    CHECK(calls.gate_mode_calls == 0);
+    CHECK(calls.plot_calls == 1 && calls.plot[0] == 5);
+}
+
+static void test_oversized_frame(void) {
+    uint8_t m[FOLLOWER_MSG_SIZE + 8];
+    setup();
+    m[0] = FOLLOWER_PLOT;
+    for (uint8_t i = 1; i < sizeof(m); i++)
+        m[i] = i & 1 ? 0x00 : i;
+    bus_send(m, sizeof(m));
+    follower_poll();
+    // truncated to the values that fit in one message
+    CHECK(calls.plot_calls == (FOLLOWER_MSG_SIZE - 1) / 2);
+    CHECK(calls.plot[0] == 2);
+}
+
+static void test_queue_full(void) {
+    setup();
+    for (uint8_t i = 0; i < FOLLOWER_QUEUE_SIZE + 4; i++)
+        SEND(FOLLOWER_HISTOGRAM_RESET);
+    follower_poll();
+    // one slot is kept empty to tell full from empty, the rest are dropped
+    CHECK(calls.histogram_reset_calls == FOLLOWER_QUEUE_SIZE - 1);
+
+    SEND(FOLLOWER_HISTOGRAM_RESET);
+    follower_poll();
+    CHECK(calls.histogram_reset_calls == FOLLOWER_QUEUE_SIZE);
+}
+
+int main(void) {
+    test_init();
+    test_deferred_to_poll();
+    test_arguments();
+    test_every_command();
+    test_short_frames();
+    test_malformed_frames();
+    test_oversized_frame();
+    test_queue_full();
+
+    if (failures) {
+        printf("follower: %d failed\n", failures);
+        return 1;
+    }
+    printf("follower: ok\n");
+    return 0;
+}